@@ -0,0 +1,159 @@
+#include "audio_probe.hpp"
+#include "wav_reader.hpp"
+#include "../../utils/mapped_file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    // Bitrates in kbps, indexed by [MPEG-1 ? 0 : 1][layer - 1][bitrate index]
+    const int BITRATES[2][3][15] = {
+        {
+            {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+            {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+        },
+        {
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+        },
+    };
+    const int MPEG1_SAMPLE_RATES[3] = {44100, 48000, 32000};
+
+    // How far past the ID3 tag we look for the first frame before giving up
+    const size_t MAX_SYNC_SEARCH = 64 * 1024;
+
+    struct FrameHeader {
+        int version;         // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+        int layer;
+        int sampleRate;
+        int channels;
+        int samplesPerFrame;
+        size_t length;       // bytes, header included
+    };
+
+    uint32_t readBE32(const unsigned char* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    bool parseFrameHeader(const unsigned char* p, FrameHeader& h) {
+        if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+
+        const int version = (p[1] >> 3) & 3;
+        const int layerBits = (p[1] >> 1) & 3;
+        const int bitrateIndex = p[2] >> 4;
+        const int rateIndex = (p[2] >> 2) & 3;
+        // Reserved values, and free-format streams whose frame length we cannot compute
+        if (version == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+            return false;
+        }
+
+        const bool mpeg1 = version == 3;
+        h.version = version;
+        h.layer = 4 - layerBits;
+        h.sampleRate = MPEG1_SAMPLE_RATES[rateIndex] >> (mpeg1 ? 0 : version == 2 ? 1 : 2);
+        h.channels = (p[3] >> 6) == 3 ? 1 : 2;
+        h.samplesPerFrame = h.layer == 1 ? 384 : (h.layer == 3 && !mpeg1) ? 576 : 1152;
+
+        const int bitrate = BITRATES[mpeg1 ? 0 : 1][h.layer - 1][bitrateIndex] * 1000;
+        const int padding = (p[2] >> 1) & 1;
+        if (h.layer == 1) {
+            h.length = static_cast<size_t>((12 * bitrate / h.sampleRate + padding) * 4);
+        } else {
+            h.length = static_cast<size_t>(h.samplesPerFrame / 8 * bitrate / h.sampleRate + padding);
+        }
+        return h.length > 4;
+    }
+
+    // Size of a leading ID3v2 tag, or 0
+    size_t id3v2Size(const unsigned char* p, size_t size) {
+        if (size < 10 || std::memcmp(p, "ID3", 3) != 0) return 0;
+        // Tag size is a 28-bit "syncsafe" integer; a footer adds another 10 bytes
+        const size_t body = (size_t(p[6] & 0x7F) << 21) | (size_t(p[7] & 0x7F) << 14) |
+                            (size_t(p[8] & 0x7F) << 7) | size_t(p[9] & 0x7F);
+        return 10 + body + ((p[5] & 0x10) ? 10 : 0);
+    }
+
+    // Finds the first frame whose successor also parses, to avoid locking onto stray 0xFF bytes
+    bool findFirstFrame(const unsigned char* data, size_t size, size_t& pos, FrameHeader& h) {
+        const size_t limit = std::min(size, pos + MAX_SYNC_SEARCH);
+        for (; pos + 4 <= limit; ++pos) {
+            if (!parseFrameHeader(data + pos, h)) continue;
+            const size_t next = pos + h.length;
+            if (next == size) return true;
+            FrameHeader following;
+            if (next + 4 <= size && parseFrameHeader(data + next, following) &&
+                following.version == h.version && following.layer == h.layer &&
+                following.sampleRate == h.sampleRate) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads a Xing/Info or VBRI tag from the first frame; frames stays 0 if the tag has no frame count
+    bool readVbrTag(const unsigned char* frame, size_t available, const FrameHeader& h, uint64_t& frames) {
+        const bool mpeg1 = h.version == 3;
+        const size_t xing = 4 + (mpeg1 ? (h.channels == 1 ? 17 : 32) : (h.channels == 1 ? 9 : 17));
+        if (available >= xing + 12 &&
+            (std::memcmp(frame + xing, "Xing", 4) == 0 || std::memcmp(frame + xing, "Info", 4) == 0)) {
+            const uint32_t flags = readBE32(frame + xing + 4);
+            frames = (flags & 1) ? readBE32(frame + xing + 8) : 0;
+            return true;
+        }
+        const size_t vbri = 4 + 32;
+        if (available >= vbri + 18 && std::memcmp(frame + vbri, "VBRI", 4) == 0) {
+            frames = readBE32(frame + vbri + 14);
+            return true;
+        }
+        return false;
+    }
+
+    bool probeMp3(const unsigned char* data, size_t size, AudioProbeResult& result) {
+        size_t pos = id3v2Size(data, size);
+        FrameHeader first;
+        if (!findFirstFrame(data, size, pos, first)) return false;
+
+        result.sampleRate = first.sampleRate;
+        result.channels = first.channels;
+
+        uint64_t frames = 0;
+        const bool tagged = readVbrTag(data + pos, size - pos, first, frames);
+        if (frames == 0) {
+            // No usable VBR tag: walk the frame headers, which is still just a few reads per frame.
+            // A tag frame without a count holds no audio, so it is not counted.
+            if (tagged) pos += first.length;
+
+            FrameHeader h;
+            while (pos + 4 <= size && parseFrameHeader(data + pos, h) && h.sampleRate == first.sampleRate) {
+                frames++;
+                pos += h.length;
+            }
+        }
+        if (frames == 0) return false;
+
+        result.duration = static_cast<float>(static_cast<double>(frames) * first.samplesPerFrame / first.sampleRate);
+        return true;
+    }
+}
+
+bool AudioProbe::probeMemory(const char* data, size_t size, AudioProbeResult& result) {
+    WavInfo wav;
+    if (WavReader::parseHeader(data, size, wav)) {
+        result.sampleRate = wav.sampleRate;
+        result.channels = wav.channels;
+        result.duration = wav.duration();
+        return true;
+    }
+    return probeMp3(reinterpret_cast<const unsigned char*>(data), size, result);
+}
+
+bool AudioProbe::probe(const std::string& path, AudioProbeResult& result) {
+    try {
+        harmony::MappedFile file(path);
+        return probeMemory(file.data(), file.size(), result);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Stream properties read from container headers, without decoding any samples
+struct AudioProbeResult {
+    int sampleRate = 0;
+    int channels = 0;
+    float duration = -1.0f; // seconds
+};
+
+// Reads duration and sample rate from file headers only:
+//   WAV - fmt/data chunks
+//   MP3 - Xing/Info or VBRI frame count, otherwise a walk over the frame headers
+// Other formats are not recognised; callers fall back to a full decode.
+class AudioProbe {
+public:
+    // Returns false if the file is missing, unreadable or not a WAV/MP3 stream
+    static bool probe(const std::string& path, AudioProbeResult& result);
+
+    // Same as probe(), on an in-memory image of the file
+    static bool probeMemory(const char* data, size_t size, AudioProbeResult& result);
+};
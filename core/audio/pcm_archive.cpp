@@ -0,0 +1,190 @@
+#include "pcm_archive.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char PCM_MAGIC[4] = {'H', 'P', 'C', 'M'};
+    const uint32_t PCM_VERSION = 1;
+    const uint64_t PCM_ALIGNMENT = 64;
+
+    struct PcmHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t sampleRate;
+        uint32_t reserved;
+        uint64_t indexOffset;
+        uint64_t entryCount;
+        char padding[32];
+    };
+    static_assert(sizeof(PcmHeader) == 64, "PCM archive header must stay 64 bytes");
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + PCM_ALIGNMENT - 1) / PCM_ALIGNMENT * PCM_ALIGNMENT;
+    }
+
+    // Parses header and index of a mapped archive
+    template <typename Entry, typename Visit>
+    void readIndex(const char* base, size_t size, uint32_t& sampleRate, uint64_t& indexOffset, Visit visit) {
+        if (size < sizeof(PcmHeader)) {
+            throw std::runtime_error("file too small for a PCM archive");
+        }
+        PcmHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, PCM_MAGIC, sizeof(PCM_MAGIC)) != 0 || header.version != PCM_VERSION) {
+            throw std::runtime_error("not a PCM archive (or unsupported version)");
+        }
+        if (header.indexOffset < sizeof(PcmHeader) || header.indexOffset > size) {
+            throw std::runtime_error("PCM archive was not closed cleanly");
+        }
+        sampleRate = header.sampleRate;
+        indexOffset = header.indexOffset;
+
+        const char* p = base + header.indexOffset;
+        const char* end = base + size;
+        for (uint64_t i = 0; i < header.entryCount; ++i) {
+            uint32_t len;
+            Entry entry;
+            if (end - p < 4) throw std::runtime_error("truncated PCM index");
+            std::memcpy(&len, p, 4);
+            p += 4;
+            if (static_cast<uint64_t>(end - p) < len + 16) throw std::runtime_error("truncated PCM index");
+            std::string name(p, len);
+            p += len;
+            std::memcpy(&entry.offset, p, 8);
+            std::memcpy(&entry.samples, p + 8, 8);
+            p += 16;
+            if (entry.offset + entry.samples * sizeof(float) > header.indexOffset) {
+                throw std::runtime_error("PCM index entry out of range: " + name);
+            }
+            visit(name, entry);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+PcmArchiveWriter::PcmArchiveWriter(const std::string& path, int sampleRate)
+    : path(path), sampleRate(sampleRate) {
+    if (fs::exists(path) && fs::file_size(path) > 0) {
+        // Reload the index; header and index stay valid until close() replaces them, so an
+        // interrupted append leaves the archive as it was
+        uint32_t existingRate = 0;
+        uint64_t indexOffset = 0;
+        {
+            harmony::MappedFile existing(path);
+            writeOffset = 0;
+            readIndex<Entry>(existing.data(), existing.size(), existingRate, indexOffset,
+                [&](const std::string& name, const Entry& entry) {
+                    writeOffset += sizeof(uint32_t) + name.size() + sizeof(entry.offset) + sizeof(entry.samples);
+                    if (!index.count(name)) order.push_back(name);
+                    index[name] = entry;
+                });
+            writeOffset += indexOffset;
+        }
+        if (static_cast<int>(existingRate) != sampleRate) {
+            throw std::runtime_error("PCM archive " + path + " holds " + std::to_string(existingRate) +
+                                     " Hz audio, cannot append " + std::to_string(sampleRate) + " Hz clips");
+        }
+        // New clips go after the old index; anything past it is left over from an interrupted append
+        fs::resize_file(path, writeOffset);
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    } else {
+        if (fs::path(path).has_parent_path()) {
+            fs::create_directories(fs::path(path).parent_path());
+        }
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        PcmHeader header{};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeOffset = sizeof(header);
+    }
+    if (!file.is_open() || !file) {
+        throw std::runtime_error("Cannot open PCM archive for writing: " + path);
+    }
+}
+
+PcmArchiveWriter::~PcmArchiveWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error closing PCM archive " << path << ": " << e.what() << std::endl;
+    }
+}
+
+void PcmArchiveWriter::add(const std::string& name, const std::vector<float>& samples) {
+    const uint64_t start = alignUp(writeOffset);
+    static const char zeros[PCM_ALIGNMENT] = {};
+    file.seekp(writeOffset);
+    file.write(zeros, start - writeOffset);
+    file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(float));
+    if (!file) {
+        throw std::runtime_error("Failed to write clip " + name + " to " + path);
+    }
+    writeOffset = start + samples.size() * sizeof(float);
+
+    if (!index.count(name)) order.push_back(name);
+    index[name] = {start, samples.size()};
+}
+
+void PcmArchiveWriter::close() {
+    if (!file.is_open()) return;
+
+    PcmHeader header{};
+    std::memcpy(header.magic, PCM_MAGIC, sizeof(PCM_MAGIC));
+    header.version = PCM_VERSION;
+    header.sampleRate = static_cast<uint32_t>(sampleRate);
+    header.indexOffset = writeOffset;
+    header.entryCount = order.size();
+
+    file.seekp(writeOffset);
+    for (const auto& name : order) {
+        const Entry& entry = index.at(name);
+        const uint32_t len = static_cast<uint32_t>(name.size());
+        file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        file.write(name.data(), len);
+        file.write(reinterpret_cast<const char*>(&entry.offset), sizeof(entry.offset));
+        file.write(reinterpret_cast<const char*>(&entry.samples), sizeof(entry.samples));
+    }
+
+    // The header goes last: a crash before this point leaves a new archive rejected and an
+    // appended one pointing at its previous index
+    file.flush();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.flush();
+    const bool ok = static_cast<bool>(file);
+    file.close();
+    if (!ok) {
+        throw std::runtime_error("Failed to finalize PCM archive " + path);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+void PcmArchive::open(const std::string& path) {
+    index.clear();
+    mapping.open(path);
+    uint32_t rate = 0;
+    uint64_t indexOffset = 0;
+    try {
+        readIndex<Entry>(mapping.data(), mapping.size(), rate, indexOffset,
+            [&](const std::string& name, const Entry& entry) { index[name] = entry; });
+    } catch (const std::exception& e) {
+        mapping.close();
+        throw std::runtime_error(path + ": " + e.what());
+    }
+    sampleRate = static_cast<int>(rate);
+}
+
+std::span<const float> PcmArchive::view(const std::string& name) const {
+    auto it = index.find(name);
+    if (it == index.end()) return {};
+    return {reinterpret_cast<const float*>(mapping.data() + it->second.offset), it->second.samples};
+}
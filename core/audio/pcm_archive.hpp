@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../utils/mapped_file.hpp"
+
+// Packed archive of decoded float32 mono clips.
+//
+// Layout (little endian):
+//   64-byte header : magic "HPCM", version, sample rate, index offset, entry count
+//   sample data    : float32 samples, every clip starting on a 64-byte boundary
+//   index          : per clip name, byte offset and sample count
+//
+// The header is written last, on close(). A new archive is only valid after a clean
+// close(); an append writes its clips and a new index after the old index, so until
+// close() rewrites the header the archive still reads as it was before the append.
+class PcmArchiveWriter {
+public:
+    // Opens an archive for writing; an existing valid archive is extended in place
+    PcmArchiveWriter(const std::string& path, int sampleRate);
+    ~PcmArchiveWriter();
+
+    PcmArchiveWriter(const PcmArchiveWriter&) = delete;
+    PcmArchiveWriter& operator=(const PcmArchiveWriter&) = delete;
+
+    // Stores a clip; adding an existing name replaces its index entry
+    void add(const std::string& name, const std::vector<float>& samples);
+
+    // Writes the index and header; called by the destructor if needed
+    void close();
+
+    size_t size() const { return index.size(); }
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t samples;
+    };
+
+    std::string path;
+    int sampleRate;
+    std::fstream file;
+    uint64_t writeOffset = 0;
+    std::vector<std::string> order;
+    std::unordered_map<std::string, Entry> index;
+};
+
+// Read-only, memory-mapped view of a PCM archive
+class PcmArchive {
+public:
+    PcmArchive() = default;
+    explicit PcmArchive(const std::string& path) { open(path); }
+
+    // Throws std::runtime_error for missing or invalid archives
+    void open(const std::string& path);
+
+    bool contains(const std::string& name) const { return index.count(name) > 0; }
+
+    // Zero-copy view of a clip's samples; empty if the clip is not in the archive
+    std::span<const float> view(const std::string& name) const;
+
+    int getSampleRate() const { return sampleRate; }
+    size_t size() const { return index.size(); }
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t samples;
+    };
+
+    harmony::MappedFile mapping;
+    int sampleRate = 0;
+    std::unordered_map<std::string, Entry> index;
+};
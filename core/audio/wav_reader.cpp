@@ -0,0 +1,179 @@
+#include "wav_reader.hpp"
+#include "../../utils/mapped_file.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    const uint16_t WAVE_FORMAT_PCM = 0x0001;
+    const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+    const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    uint16_t readU16(const char* p) {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t readU32(const char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    bool isSupported(const WavInfo& info) {
+        if (info.channels <= 0 || info.sampleRate <= 0) return false;
+        if (info.format == WAVE_FORMAT_PCM) {
+            return info.bitsPerSample == 16 || info.bitsPerSample == 24 || info.bitsPerSample == 32;
+        }
+        return info.format == WAVE_FORMAT_IEEE_FLOAT && info.bitsPerSample == 32;
+    }
+
+    // Averages interleaved channels in place; out[i] may alias in[i * channels]
+    void downmix(float* data, size_t frames, int channels) {
+        const float scale = 1.0f / static_cast<float>(channels);
+        for (size_t i = 0; i < frames; ++i) {
+            const float* frame = data + i * channels;
+            float sum = 0.0f;
+            for (int c = 0; c < channels; ++c) sum += frame[c];
+            data[i] = sum * scale;
+        }
+    }
+}
+
+bool WavReader::parseHeader(const char* data, size_t size, WavInfo& info) {
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool haveFormat = false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const char* chunk = data + pos;
+        const uint32_t chunkSize = readU32(chunk + 4);
+        const size_t body = pos + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || body + 16 > size) return false;
+            info.format = readU16(data + body);
+            info.channels = readU16(data + body + 2);
+            info.sampleRate = static_cast<int>(readU32(data + body + 4));
+            info.bitsPerSample = readU16(data + body + 14);
+            if (info.format == WAVE_FORMAT_EXTENSIBLE) {
+                // The real format code is the first two bytes of the SubFormat GUID
+                if (chunkSize < 40 || body + 26 > size) return false;
+                info.format = readU16(data + body + 24);
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat || !isSupported(info)) return false;
+            // Streamed writers leave the size at 0 or 0xFFFFFFFF; trust the file length instead
+            uint64_t dataBytes = chunkSize;
+            if (dataBytes == 0 || dataBytes == 0xFFFFFFFFu || body + dataBytes > size) {
+                dataBytes = size - body;
+            }
+            const uint64_t frameBytes = static_cast<uint64_t>(info.channels) * (info.bitsPerSample / 8);
+            info.dataOffset = body;
+            info.frames = dataBytes / frameBytes;
+            return true;
+        }
+
+        // Chunks are padded to an even length
+        pos = body + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+bool WavReader::probe(const std::string& path, WavInfo& info) {
+    try {
+        harmony::MappedFile file(path);
+        return parseHeader(file.data(), file.size(), info);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+void WavReader::convertInt16(const int16_t* in, float* out, size_t count) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m256i s32 = _mm256_cvtepi16_epi32(s16);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s32), vscale));
+    }
+#elif defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend by placing each sample in the high half of a 32-bit lane and shifting back
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+bool WavReader::read(const std::string& path, std::vector<float>& samples, int& sampleRate) {
+    harmony::MappedFile file;
+    try {
+        file.open(path);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    WavInfo info;
+    if (!parseHeader(file.data(), file.size(), info)) {
+        return false;
+    }
+    file.advise(MADV_SEQUENTIAL);
+
+    const size_t count = static_cast<size_t>(info.frames) * info.channels;
+    const char* src = file.data() + info.dataOffset;
+    // Decode straight into the caller's buffer so its capacity is reused across files
+    std::vector<float>& decoded = samples;
+    decoded.resize(count);
+
+    if (info.format == WAVE_FORMAT_IEEE_FLOAT) {
+        std::memcpy(decoded.data(), src, count * sizeof(float));
+    } else if (info.bitsPerSample == 16) {
+        // The data chunk may sit at an odd offset, so the SIMD loop uses unaligned loads
+        if (reinterpret_cast<uintptr_t>(src) % alignof(int16_t) == 0) {
+            convertInt16(reinterpret_cast<const int16_t*>(src), decoded.data(), count);
+        } else {
+            std::vector<int16_t> aligned(count);
+            std::memcpy(aligned.data(), src, count * sizeof(int16_t));
+            convertInt16(aligned.data(), decoded.data(), count);
+        }
+    } else if (info.bitsPerSample == 24) {
+        const float scale = 1.0f / 8388608.0f;
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* b = reinterpret_cast<const unsigned char*>(src + 3 * i);
+            const int32_t v = static_cast<int32_t>((uint32_t(b[0]) << 8) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 24)) >> 8;
+            decoded[i] = static_cast<float>(v) * scale;
+        }
+    } else {
+        const float scale = 1.0f / 2147483648.0f;
+        for (size_t i = 0; i < count; ++i) {
+            int32_t v;
+            std::memcpy(&v, src + 4 * i, sizeof(v));
+            decoded[i] = static_cast<float>(v) * scale;
+        }
+    }
+
+    if (info.channels > 1) {
+        downmix(decoded.data(), info.frames, info.channels);
+        decoded.resize(info.frames);
+    }
+
+    sampleRate = info.sampleRate;
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stream parameters of a RIFF/WAVE file, taken from its fmt and data chunks
+struct WavInfo {
+    int format = 0;          // 1 = integer PCM, 3 = IEEE float (WAVE_FORMAT_EXTENSIBLE is resolved)
+    int channels = 0;
+    int sampleRate = 0;
+    int bitsPerSample = 0;
+    uint64_t dataOffset = 0; // byte offset of the first sample
+    uint64_t frames = 0;     // samples per channel
+
+    float duration() const {
+        return sampleRate > 0 ? static_cast<float>(frames) / static_cast<float>(sampleRate) : -1.0f;
+    }
+};
+
+// Native decoder for uncompressed WAV files (16/24/32-bit PCM and 32-bit float).
+// The file is memory mapped and converted straight into the caller's buffer, so the
+// common case of reading our own preprocessed 16 kHz clips skips FFmpeg entirely.
+class WavReader {
+public:
+    // Parses the header of an in-memory RIFF/WAVE image; false if it is not a WAV we can decode
+    static bool parseHeader(const char* data, size_t size, WavInfo& info);
+
+    // Header-only probe of a file; false for non-WAV or unsupported encodings
+    static bool probe(const std::string& path, WavInfo& info);
+
+    // Decodes a WAV file to mono float samples in [-1, 1), averaging channels like MonoLoader.
+    // Returns false without touching samples if the file is not a supported WAV;
+    // callers are expected to fall back to MonoLoader in that case. The existing
+    // capacity of samples is reused, so reading into the same buffer does not reallocate.
+    static bool read(const std::string& path, std::vector<float>& samples, int& sampleRate);
+
+    // Converts interleaved int16 samples to float (x / 32768) using SIMD where available
+    static void convertInt16(const int16_t* in, float* out, size_t count);
+};
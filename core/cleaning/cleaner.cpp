@@ -5,6 +5,7 @@
 #include <random>
 #include <iostream>
 #include <filesystem>
+#include "../audio/audio_probe.hpp"
 
 #define MAX_ROWS 15000
 
@@ -24,69 +25,92 @@ void DatasetCleaner::cleanMetadata()
         throw std::runtime_error("Could not open metadata file: " + metadataFilePath);
     }
 
-    // Count number of lines for progress bar
-    size_t lineCount = 0;
+    // Single pass over the file; rows are probed from memory afterwards
+    std::vector<std::string> lines;
     std::string line;
     while (std::getline(file, line))
     {
-        lineCount++;
+        lines.push_back(std::move(line));
     }
-
-    file.clear();
-    file.seekg(0, std::ios::beg);
+    file.close();
+    const size_t lineCount = lines.size();
 
     // Initialize progress bar
     Tqdm tqdm(lineCount, "Cleaning metadata");
     std::vector<std::string> cleanedMetadata;
 
-    int cnt = 0;
+    // Rows are probed in parallel blocks and kept in file order, so we stop probing
+    // shortly after MAX_ROWS valid rows instead of touching every file in the dataset
+    const size_t blockSize = 4096;
+    std::vector<std::string> blockResults;
 
-    while (std::getline(file, line))
+    for (size_t blockStart = 0; blockStart < lineCount && cleanedMetadata.size() < MAX_ROWS; blockStart += blockSize)
     {
-        if(cnt >= MAX_ROWS)
+        const size_t blockEnd = std::min(lineCount, blockStart + blockSize);
+        blockResults.assign(blockEnd - blockStart, std::string());
+
+#pragma omp parallel for schedule(dynamic, 16)
+        for (size_t i = blockStart; i < blockEnd; ++i)
         {
-            break;
-        }
+            std::stringstream ss(lines[i]);
+            std::string token;
+            std::vector<std::string> tokens;
 
-        std::stringstream ss(line);
-        std::string token;
-        std::vector<std::string> tokens;
+            // Split by tab
+            while (std::getline(ss, token, '\t'))
+            {
+                tokens.push_back(token);
+            }
 
-        // Split by tab
-        while (std::getline(ss, token, '\t'))
-        {
-            tokens.push_back(token);
-        }
+            // Check if enough tokens exist
+            if (tokens.size() < 7)
+            {
+                continue;
+            }
 
-        // Check if enough tokens exist
-        if (tokens.size() < 7)
-        {
-            tqdm.update();
-            continue;
-        }
+            // Check if the file exists AND can be opened
+            std::string fullPath = datasetPath + "/" + tokens[1];
+            if (!fs::exists(fullPath))
+            {
+                continue;
+            }
 
-        // Check if the file exists AND can be opened
-        std::string filename = tokens[1];
-        std::string fullPath = datasetPath + "/" + filename;
+            // Duration comes from the container headers; only unknown formats are decoded
+            float duration = -1.0f;
+            AudioProbeResult probe;
+            if (AudioProbe::probe(fullPath, probe))
+            {
+                duration = probe.duration;
+            }
+            else
+            {
+                try
+                {
+                    int sampleRate = 0;
+                    AudioUtil::readAudioFile(fullPath, duration, sampleRate);
+                }
+                catch (const std::exception &)
+                {
+                    duration = -1.0f;
+                }
+            }
 
-        float duration = -1.0f;
-        int sampleRate = 0;
-        if (fs::exists(fullPath))
-        {
-           AudioUtil::readAudioFile(fullPath, duration, sampleRate);
+            if (duration > 0)
+            {
+                blockResults[i - blockStart] = tokens[1] + "\t" + tokens[5] + "\t" + tokens[6] + "\t" + std::to_string(duration);
+            }
         }
 
-        if (duration > 0)
+        for (auto &result : blockResults)
         {
-            std::string cleanedLine = tokens[1] + "\t" + tokens[5] + "\t" + tokens[6] + "\t" + std::to_string(duration);
-            cleanedMetadata.push_back(cleanedLine);
-            cnt++;
+            if (!result.empty() && cleanedMetadata.size() < MAX_ROWS)
+            {
+                cleanedMetadata.push_back(std::move(result));
+            }
         }
-
-        tqdm.update();
+        tqdm.update(static_cast<int>(blockEnd - blockStart));
     }
 
-    file.close();
     tqdm.finish();
 
     // Save cleaned metadata to a new file
@@ -0,0 +1,193 @@
+#include "extraction_journal.hpp"
+#include "../../utils/mapped_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace harmony
+{
+    namespace
+    {
+        void putString(std::ostream &out, const std::string &s)
+        {
+            const uint32_t len = static_cast<uint32_t>(s.size());
+            out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+            out.write(s.data(), len);
+        }
+
+        /// fsync through a descriptor of our own; std::ofstream does not expose one
+        void syncPath(const std::string &path, bool directory = false)
+        {
+            const int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("cannot open " + path + " to sync it");
+            const int result = ::fsync(fd);
+            ::close(fd);
+            if (result != 0)
+                throw std::runtime_error("fsync failed for " + path);
+        }
+
+        /// Decodes the record at p; returns false if it runs past end
+        bool readRecord(const char *&p, const char *end, JournalRecord &record)
+        {
+            auto u32 = [&](uint32_t &v) {
+                if (end - p < 4)
+                    return false;
+                std::memcpy(&v, p, sizeof(v));
+                p += sizeof(v);
+                return true;
+            };
+            auto str = [&](std::string &s) {
+                uint32_t len;
+                if (!u32(len) || static_cast<uint64_t>(end - p) < len)
+                    return false;
+                s.assign(p, len);
+                p += len;
+                return true;
+            };
+
+            uint32_t n;
+            if (!str(record.path) || !str(record.ageLabel) || !str(record.genderLabel) || !u32(n))
+                return false;
+            if (static_cast<uint64_t>(end - p) < static_cast<uint64_t>(n) * sizeof(float))
+                return false;
+            record.features.resize(n);
+            std::memcpy(record.features.data(), p, n * sizeof(float));
+            p += n * sizeof(float);
+            return true;
+        }
+    }
+
+    ExtractionJournal::ExtractionJournal(const std::string &directory, const std::string &name,
+                                         const std::string &signature)
+        : directory_(directory), signature_(signature)
+    {
+        fs::create_directories(directory);
+        rowsPath_ = (fs::path(directory) / (name + ".rows")).string();
+        manifestPath_ = (fs::path(directory) / (name + ".manifest")).string();
+
+        // Committed state; without a manifest nothing was ever committed
+        std::ifstream manifest(manifestPath_);
+        std::string committedSignature;
+        if (manifest.is_open())
+        {
+            std::string key;
+            while (manifest >> key)
+            {
+                if (key == "offset")
+                    manifest >> committedOffset_;
+                else if (key == "rows")
+                    manifest >> committedRows_;
+                else if (key == "signature")
+                {
+                    std::getline(manifest >> std::ws, committedSignature);
+                }
+            }
+        }
+
+        // Rows from another preprocessing chain would be mixed into the same split
+        if (committedRows_ > 0 && committedSignature != signature_)
+            throw std::runtime_error(manifestPath_ + " was written with preprocessing '" +
+                                     (committedSignature.empty() ? "unknown" : committedSignature) +
+                                     "' but this run uses '" + signature_ + "'; rerun with --restart");
+
+        if (fs::exists(rowsPath_))
+        {
+            const uint64_t size = fs::file_size(rowsPath_);
+            if (size < committedOffset_)
+                throw std::runtime_error(rowsPath_ + " is shorter than its manifest");
+            if (size > committedOffset_)
+                fs::resize_file(rowsPath_, committedOffset_);
+        }
+        else if (committedOffset_ > 0)
+        {
+            throw std::runtime_error(rowsPath_ + " is missing but its manifest is not empty");
+        }
+
+        size_t rows = 0;
+        forEach([&](const JournalRecord &record) {
+            completed_.insert(record.path);
+            rows++;
+        });
+        if (rows != committedRows_)
+            throw std::runtime_error(rowsPath_ + " holds " + std::to_string(rows) + " records, manifest says " +
+                                     std::to_string(committedRows_));
+
+        rows_.open(rowsPath_, std::ios::binary | std::ios::app);
+        if (!rows_.is_open())
+            throw std::runtime_error("cannot open " + rowsPath_);
+        writtenOffset_ = committedOffset_;
+    }
+
+    void ExtractionJournal::append(const JournalRecord &record)
+    {
+        putString(rows_, record.path);
+        putString(rows_, record.ageLabel);
+        putString(rows_, record.genderLabel);
+        const uint32_t n = static_cast<uint32_t>(record.features.size());
+        rows_.write(reinterpret_cast<const char *>(&n), sizeof(n));
+        rows_.write(reinterpret_cast<const char *>(record.features.data()), n * sizeof(float));
+
+        writtenOffset_ += 4 * sizeof(uint32_t) + record.path.size() + record.ageLabel.size() +
+                          record.genderLabel.size() + n * sizeof(float);
+        pending_.push_back(record.path);
+    }
+
+    void ExtractionJournal::commit()
+    {
+        rows_.flush();
+        if (!rows_)
+            throw std::runtime_error("failed to write " + rowsPath_);
+        // Rows must be on disk before a manifest that points past them
+        syncPath(rowsPath_);
+
+        committedOffset_ = writtenOffset_;
+        committedRows_ += pending_.size();
+        writeManifest();
+
+        completed_.insert(pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+
+    void ExtractionJournal::writeManifest() const
+    {
+        // Write-then-rename keeps the previous manifest intact if we die mid-write
+        const std::string tmpPath = manifestPath_ + ".tmp";
+        {
+            std::ofstream tmp(tmpPath, std::ios::trunc);
+            tmp << "offset " << committedOffset_ << "\n"
+                << "rows " << committedRows_ << "\n"
+                << "signature " << signature_ << "\n";
+            tmp.flush();
+            if (!tmp)
+                throw std::runtime_error("failed to write " + tmpPath);
+        }
+        syncPath(tmpPath);
+        fs::rename(tmpPath, manifestPath_);
+        // Persists the rename (and the rows file's entry, created in the same directory)
+        syncPath(directory_, true);
+    }
+
+    void ExtractionJournal::forEach(const std::function<void(const JournalRecord &)> &visit) const
+    {
+        if (committedOffset_ == 0 || !fs::exists(rowsPath_))
+            return;
+
+        MappedFile file(rowsPath_);
+        file.advise(MADV_SEQUENTIAL);
+        const char *p = file.data();
+        const char *end = p + std::min<uint64_t>(file.size(), committedOffset_);
+        JournalRecord record;
+        while (p < end)
+        {
+            if (!readRecord(p, end, record))
+                throw std::runtime_error(rowsPath_ + " contains a corrupt record");
+            visit(record);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+#include <unordered_set>
+
+namespace harmony
+{
+
+	/**
+	 * @brief One extracted sample as stored in the journal
+	 */
+	struct JournalRecord
+	{
+		std::string path;
+		std::string ageLabel;
+		std::string genderLabel;
+		std::vector<float> features;
+	};
+
+	/**
+	 * @brief Append-only, checkpointed store of extracted feature rows
+	 * Records are appended to <name>.rows. commit() fsyncs them and atomically
+	 * rewrites <name>.manifest with the committed byte offset, row count and the
+	 * signature of the preprocessing that produced the rows; the manifest and
+	 * its directory are fsynced around the rename, so a committed checkpoint
+	 * survives a power loss. On reopen, anything past the committed offset (rows
+	 * written after the last checkpoint of a crashed run) is truncated away, so
+	 * the journal always resumes from a consistent state.
+	 */
+	class ExtractionJournal
+	{
+	public:
+		/**
+		 * @brief Opens or creates a journal
+		 * @param directory Directory holding the journal files (created if missing)
+		 * @param name Journal name, e.g. "train" or "test"
+		 * @param signature Preprocessing signature of the rows ("none" without preprocessing)
+		 * @throws std::runtime_error if the files cannot be opened or are corrupt, or if the
+		 * committed rows were produced under another signature
+		 */
+		ExtractionJournal(const std::string &directory, const std::string &name, const std::string &signature);
+
+		/**
+		 * @brief Paths of all committed records
+		 */
+		const std::unordered_set<std::string> &completed() const { return completed_; }
+
+		/**
+		 * @brief Appends a record; it becomes durable at the next commit()
+		 */
+		void append(const JournalRecord &record);
+
+		/**
+		 * @brief Flushes appended records and advances the manifest
+		 */
+		void commit();
+
+		/**
+		 * @brief Number of records that survived the last commit
+		 */
+		size_t committedRows() const { return committedRows_; }
+
+		/**
+		 * @brief Visits every committed record in append order
+		 */
+		void forEach(const std::function<void(const JournalRecord &)> &visit) const;
+
+	private:
+		std::string directory_;
+		std::string rowsPath_;
+		std::string manifestPath_;
+		std::string signature_;
+		std::ofstream rows_;
+		std::unordered_set<std::string> completed_;
+		std::vector<std::string> pending_;
+		uint64_t committedOffset_ = 0;
+		size_t committedRows_ = 0;
+		uint64_t writtenOffset_ = 0;
+
+		void writeManifest() const;
+	};
+
+}
@@ -0,0 +1,346 @@
+#include "feature_store.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#ifdef HARMONY_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace harmony
+{
+    namespace
+    {
+        constexpr char MAGIC[4] = {'H', 'F', 'S', '1'};
+        constexpr uint32_t VERSION = 1;
+        constexpr uint64_t ALIGNMENT = 64;
+
+        struct Preamble
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t flags;
+            uint32_t dtype;
+            uint64_t rows;
+            uint64_t cols;
+            uint64_t dataOffset;
+            uint64_t dataBytes;
+            uint64_t labelOffset;
+            uint64_t labelBytes;
+        };
+        static_assert(sizeof(Preamble) == 64, "feature store preamble must stay 64 bytes");
+
+        uint64_t alignUp(uint64_t offset)
+        {
+            return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        void putU32(std::string &buf, uint32_t v)
+        {
+            buf.append(reinterpret_cast<const char *>(&v), sizeof(v));
+        }
+
+        void putString(std::string &buf, const std::string &s)
+        {
+            putU32(buf, static_cast<uint32_t>(s.size()));
+            buf.append(s);
+        }
+
+        /// Bounds-checked cursor over the mapped header
+        struct Cursor
+        {
+            const char *p;
+            const char *end;
+
+            uint32_t u32()
+            {
+                if (end - p < 4)
+                    throw std::runtime_error("truncated header");
+                uint32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                p += sizeof(v);
+                return v;
+            }
+
+            std::string str()
+            {
+                const uint32_t len = u32();
+                if (static_cast<uint64_t>(end - p) < len)
+                    throw std::runtime_error("truncated header");
+                std::string s(p, len);
+                p += len;
+                return s;
+            }
+        };
+
+        std::string deflateBlock(const char *src, size_t bytes)
+        {
+#ifdef HARMONY_HAS_ZLIB
+            uLongf outLen = compressBound(bytes);
+            std::string out(outLen, '\0');
+            if (compress2(reinterpret_cast<Bytef *>(out.data()), &outLen,
+                          reinterpret_cast<const Bytef *>(src), bytes, Z_BEST_SPEED) != Z_OK)
+                throw std::runtime_error("zlib compression failed");
+            out.resize(outLen);
+            return out;
+#else
+            (void)src;
+            (void)bytes;
+            throw std::runtime_error("built without zlib, compression unavailable");
+#endif
+        }
+
+        void inflateBlock(const char *src, size_t bytes, void *dst, size_t dstBytes)
+        {
+#ifdef HARMONY_HAS_ZLIB
+            uLongf outLen = dstBytes;
+            if (uncompress(reinterpret_cast<Bytef *>(dst), &outLen,
+                           reinterpret_cast<const Bytef *>(src), bytes) != Z_OK ||
+                outLen != dstBytes)
+                throw std::runtime_error("zlib decompression failed");
+#else
+            (void)src;
+            (void)bytes;
+            (void)dst;
+            (void)dstBytes;
+            throw std::runtime_error("store is compressed but zlib support is not built in");
+#endif
+        }
+    }
+
+    int encodeTarget(std::string_view ageLabel, std::string_view genderLabel, std::string_view target)
+    {
+        const int ageCode = (ageLabel == "twenties") ? 0 : 1;
+        const int genderCode = (genderLabel == "male") ? 0 : 1;
+        if (target == "gender")
+            return genderCode;
+        if (target == "age")
+            return ageCode;
+        // 0: Male + Twenties, 1: Female + Twenties, 2: Male + Fifties, 3: Female + Fifties
+        return ageCode * 2 + genderCode;
+    }
+
+    //--------------------------------------------------------------------------------------
+    //-----------------------------Feature Store Writer-------------------------------------
+    //--------------------------------------------------------------------------------------
+    FeatureStoreWriter::FeatureStoreWriter(std::vector<std::string> featureNames, std::vector<std::string> labelNames)
+        : featureNames_(std::move(featureNames)), labelNames_(std::move(labelNames)),
+          vocabularies_(labelNames_.size()), codes_(labelNames_.size())
+    {
+    }
+
+    void FeatureStoreWriter::addRow(const std::vector<float> &features, const std::vector<std::string> &labels)
+    {
+        if (features.size() != featureNames_.size())
+            throw std::invalid_argument("FeatureStoreWriter: expected " + std::to_string(featureNames_.size()) +
+                                        " features, got " + std::to_string(features.size()));
+        if (labels.size() != labelNames_.size())
+            throw std::invalid_argument("FeatureStoreWriter: expected " + std::to_string(labelNames_.size()) +
+                                        " labels, got " + std::to_string(labels.size()));
+
+        rowMajor_.insert(rowMajor_.end(), features.begin(), features.end());
+        for (size_t l = 0; l < labels.size(); ++l)
+        {
+            auto &vocab = vocabularies_[l];
+            auto it = std::find(vocab.begin(), vocab.end(), labels[l]);
+            if (it == vocab.end())
+                it = vocab.insert(vocab.end(), labels[l]);
+            codes_[l].push_back(static_cast<int32_t>(it - vocab.begin()));
+        }
+        nRows_++;
+    }
+
+    bool FeatureStoreWriter::save(const std::string &path, bool compress) const
+    {
+        try
+        {
+            const size_t nCols = featureNames_.size();
+
+            // Column-major so a loaded store maps directly onto Eigen's default layout
+            std::vector<float> columns(nRows_ * nCols);
+            for (size_t r = 0; r < nRows_; ++r)
+                for (size_t c = 0; c < nCols; ++c)
+                    columns[c * nRows_ + r] = rowMajor_[r * nCols + c];
+
+            std::vector<int32_t> labels;
+            labels.reserve(nRows_ * codes_.size());
+            for (const auto &column : codes_)
+                labels.insert(labels.end(), column.begin(), column.end());
+
+            std::string dataBlock(reinterpret_cast<const char *>(columns.data()), columns.size() * sizeof(float));
+            std::string labelBlock(reinterpret_cast<const char *>(labels.data()), labels.size() * sizeof(int32_t));
+            if (compress)
+            {
+                dataBlock = deflateBlock(dataBlock.data(), dataBlock.size());
+                labelBlock = deflateBlock(labelBlock.data(), labelBlock.size());
+            }
+
+            std::string header;
+            putU32(header, static_cast<uint32_t>(nCols));
+            for (const auto &name : featureNames_)
+                putString(header, name);
+            putU32(header, static_cast<uint32_t>(labelNames_.size()));
+            for (size_t l = 0; l < labelNames_.size(); ++l)
+            {
+                putString(header, labelNames_[l]);
+                putU32(header, static_cast<uint32_t>(vocabularies_[l].size()));
+                for (const auto &value : vocabularies_[l])
+                    putString(header, value);
+            }
+
+            Preamble pre{};
+            std::memcpy(pre.magic, MAGIC, sizeof(MAGIC));
+            pre.version = VERSION;
+            pre.flags = compress ? FeatureStore::FLAG_ZLIB : 0u;
+            pre.dtype = FeatureStore::DTYPE_FLOAT32;
+            pre.rows = nRows_;
+            pre.cols = nCols;
+            pre.dataOffset = alignUp(sizeof(Preamble) + header.size());
+            pre.dataBytes = dataBlock.size();
+            pre.labelOffset = alignUp(pre.dataOffset + pre.dataBytes);
+            pre.labelBytes = labelBlock.size();
+
+            std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+            if (!ofs.is_open())
+                throw std::runtime_error("cannot open " + path);
+
+            const std::string padding(ALIGNMENT, '\0');
+            ofs.write(reinterpret_cast<const char *>(&pre), sizeof(pre));
+            ofs.write(header.data(), header.size());
+            ofs.write(padding.data(), pre.dataOffset - sizeof(Preamble) - header.size());
+            ofs.write(dataBlock.data(), dataBlock.size());
+            ofs.write(padding.data(), pre.labelOffset - pre.dataOffset - pre.dataBytes);
+            ofs.write(labelBlock.data(), labelBlock.size());
+            return static_cast<bool>(ofs);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error saving feature store: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    //-----------------------------Feature Store--------------------------------------------
+    //--------------------------------------------------------------------------------------
+    FeatureStore::~FeatureStore()
+    {
+        close();
+    }
+
+    bool FeatureStore::isFeatureStore(const std::string &path)
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        char magic[4] = {};
+        ifs.read(magic, sizeof(magic));
+        return ifs && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    bool FeatureStore::open(const std::string &path)
+    {
+        close();
+        try
+        {
+            mapping_.open(path);
+            const size_t mappingSize = mapping_.size();
+            if (mappingSize < sizeof(Preamble))
+                throw std::runtime_error(path + " is too small to be a feature store");
+
+            const char *base = mapping_.data();
+            Preamble pre;
+            std::memcpy(&pre, base, sizeof(pre));
+            if (std::memcmp(pre.magic, MAGIC, sizeof(MAGIC)) != 0)
+                throw std::runtime_error(path + " is not a feature store");
+            if (pre.version != VERSION || pre.dtype != DTYPE_FLOAT32)
+                throw std::runtime_error("unsupported feature store version or dtype");
+            if (pre.dataOffset + pre.dataBytes > mappingSize || pre.labelOffset + pre.labelBytes > mappingSize)
+                throw std::runtime_error("truncated feature store");
+
+            rows_ = static_cast<Eigen::Index>(pre.rows);
+            cols_ = static_cast<Eigen::Index>(pre.cols);
+
+            Cursor cursor{base + sizeof(Preamble), base + pre.dataOffset};
+            const uint32_t nFeatures = cursor.u32();
+            if (nFeatures != pre.cols)
+                throw std::runtime_error("feature name count does not match column count");
+            featureNames_.reserve(nFeatures);
+            for (uint32_t i = 0; i < nFeatures; ++i)
+                featureNames_.push_back(cursor.str());
+            const uint32_t nLabels = cursor.u32();
+            for (uint32_t l = 0; l < nLabels; ++l)
+            {
+                labelNames_.push_back(cursor.str());
+                vocabularies_.emplace_back(cursor.u32());
+                for (auto &value : vocabularies_.back())
+                    value = cursor.str();
+            }
+
+            const size_t dataBytes = static_cast<size_t>(rows_) * cols_ * sizeof(float);
+            const size_t labelBytes = static_cast<size_t>(rows_) * nLabels * sizeof(int32_t);
+            if (pre.flags & FLAG_ZLIB)
+            {
+                inflatedData_.resize(static_cast<size_t>(rows_) * cols_);
+                inflatedLabels_.resize(static_cast<size_t>(rows_) * nLabels);
+                inflateBlock(base + pre.dataOffset, pre.dataBytes, inflatedData_.data(), dataBytes);
+                inflateBlock(base + pre.labelOffset, pre.labelBytes, inflatedLabels_.data(), labelBytes);
+                data_ = inflatedData_.data();
+                labels_ = inflatedLabels_.data();
+
+                // Nothing references the mapping any more
+                mapping_.close();
+            }
+            else
+            {
+                if (pre.dataBytes != dataBytes || pre.labelBytes != labelBytes)
+                    throw std::runtime_error("block sizes do not match the header");
+                data_ = reinterpret_cast<const float *>(base + pre.dataOffset);
+                labels_ = reinterpret_cast<const int32_t *>(base + pre.labelOffset);
+                mapping_.advise(MADV_SEQUENTIAL);
+            }
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error loading feature store: " << e.what() << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    void FeatureStore::close()
+    {
+        mapping_.close();
+        rows_ = cols_ = 0;
+        data_ = nullptr;
+        labels_ = nullptr;
+        inflatedData_.clear();
+        inflatedLabels_.clear();
+        featureNames_.clear();
+        labelNames_.clear();
+        vocabularies_.clear();
+    }
+
+    FeatureStore::FeatureMap FeatureStore::features() const
+    {
+        return FeatureMap(data_, rows_, cols_);
+    }
+
+    size_t FeatureStore::labelIndex(const std::string &name) const
+    {
+        auto it = std::find(labelNames_.begin(), labelNames_.end(), name);
+        if (it == labelNames_.end())
+            throw std::out_of_range("feature store has no label column '" + name + "'");
+        return it - labelNames_.begin();
+    }
+
+    FeatureStore::LabelMap FeatureStore::labelCodes(const std::string &name) const
+    {
+        return LabelMap(labels_ + labelIndex(name) * rows_, rows_);
+    }
+
+    const std::vector<std::string> &FeatureStore::vocabulary(const std::string &name) const
+    {
+        return vocabularies_[labelIndex(name)];
+    }
+}
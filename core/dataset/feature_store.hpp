@@ -0,0 +1,146 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <eigen3/Eigen/Dense>
+#include "../../utils/mapped_file.hpp"
+
+namespace harmony
+{
+
+	/**
+	 * @brief Maps raw metadata labels to the class index used by the classifiers
+	 * @param ageLabel Age group label ("twenties" or "fifties")
+	 * @param genderLabel Gender label ("male" or "female")
+	 * @param target Prediction target: "gender", "age" or "both"
+	 * @return 0/1 for single targets, ageCode * 2 + genderCode (0-3) for "both"
+	 */
+	int encodeTarget(std::string_view ageLabel, std::string_view genderLabel, std::string_view target);
+
+	/**
+	 * @brief Accumulates extracted feature rows and writes them as a Harmony feature store (.hfs)
+	 *
+	 * File layout (little endian):
+	 *   - fixed 64-byte preamble: magic "HFS1", version, flags, dtype, rows, cols,
+	 *     data offset, data bytes, label offset, label bytes
+	 *   - header: feature names, label column names and their vocabularies
+	 *   - feature block at a 64-byte aligned offset: float32, column-major (rows x cols)
+	 *   - label block at a 64-byte aligned offset: int32 vocabulary codes, one column per label
+	 * With FLAG_ZLIB both blocks are deflated independently.
+	 */
+	class FeatureStoreWriter
+	{
+	public:
+		/**
+		 * @brief Constructs a writer
+		 * @param featureNames Name of every feature column
+		 * @param labelNames Name of every label column (e.g. "age", "gender")
+		 */
+		FeatureStoreWriter(std::vector<std::string> featureNames, std::vector<std::string> labelNames);
+
+		/**
+		 * @brief Appends one sample
+		 * @param features Feature values (must match the number of feature names)
+		 * @param labels Label values, one per label column
+		 */
+		void addRow(const std::vector<float> &features, const std::vector<std::string> &labels);
+
+		/**
+		 * @brief Number of rows added so far
+		 */
+		size_t rows() const { return nRows_; }
+
+		/**
+		 * @brief Writes the store to a file
+		 * @param path Output file path
+		 * @param compress Deflate the data blocks (requires zlib support)
+		 * @return true if successful, false otherwise
+		 */
+		bool save(const std::string &path, bool compress = false) const;
+
+	private:
+		std::vector<std::string> featureNames_;
+		std::vector<std::string> labelNames_;
+		std::vector<std::vector<std::string>> vocabularies_;
+		std::vector<float> rowMajor_;             // rows x cols, transposed on save
+		std::vector<std::vector<int32_t>> codes_; // one vector per label column
+		size_t nRows_ = 0;
+	};
+
+	/**
+	 * @brief Read-only view of a Harmony feature store
+	 * Uncompressed stores are memory-mapped and exposed through Eigen::Map without
+	 * copying; compressed stores are inflated once into an owned buffer.
+	 */
+	class FeatureStore
+	{
+	public:
+		using FeatureMap = Eigen::Map<const Eigen::MatrixXf>;
+		using LabelMap = Eigen::Map<const Eigen::VectorXi>;
+
+		static constexpr uint32_t FLAG_ZLIB = 1u;
+		static constexpr uint32_t DTYPE_FLOAT32 = 0u;
+
+		FeatureStore() = default;
+		~FeatureStore();
+		FeatureStore(const FeatureStore &) = delete;
+		FeatureStore &operator=(const FeatureStore &) = delete;
+
+		/**
+		 * @brief Returns true if the file starts with the feature store magic
+		 */
+		static bool isFeatureStore(const std::string &path);
+
+		/**
+		 * @brief Maps a store into memory
+		 * @param path Path to the .hfs file
+		 * @return true if successful, false otherwise
+		 */
+		bool open(const std::string &path);
+
+		/**
+		 * @brief Unmaps the file and releases any inflated buffers
+		 */
+		void close();
+
+		Eigen::Index rows() const { return rows_; }
+		Eigen::Index cols() const { return cols_; }
+
+		/**
+		 * @brief Feature matrix (rows x cols), valid until close()
+		 */
+		FeatureMap features() const;
+
+		const std::vector<std::string> &featureNames() const { return featureNames_; }
+		const std::vector<std::string> &labelNames() const { return labelNames_; }
+
+		/**
+		 * @brief Vocabulary codes of a label column
+		 * @throws std::out_of_range if the column does not exist
+		 */
+		LabelMap labelCodes(const std::string &name) const;
+
+		/**
+		 * @brief Distinct values of a label column, indexed by code
+		 * @throws std::out_of_range if the column does not exist
+		 */
+		const std::vector<std::string> &vocabulary(const std::string &name) const;
+
+	private:
+		MappedFile mapping_;
+		Eigen::Index rows_ = 0;
+		Eigen::Index cols_ = 0;
+		const float *data_ = nullptr;
+		const int32_t *labels_ = nullptr;
+		std::vector<float> inflatedData_;
+		std::vector<int32_t> inflatedLabels_;
+		std::vector<std::string> featureNames_;
+		std::vector<std::string> labelNames_;
+		std::vector<std::vector<std::string>> vocabularies_;
+
+		size_t labelIndex(const std::string &name) const;
+	};
+
+}
@@ -0,0 +1,162 @@
+#include "tsv_loader.hpp"
+#include "feature_store.hpp"
+#include "../../utils/mapped_file.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <omp.h>
+
+namespace harmony
+{
+    namespace
+    {
+        /// Target chunk size; small files still get one chunk per thread
+        constexpr size_t CHUNK_BYTES = 4 << 20;
+
+        struct Chunk
+        {
+            const char *begin;
+            const char *end;
+            Eigen::Index firstRow = 0;
+            Eigen::Index rows = 0;
+        };
+
+        /// Returns the end of the line starting at p (excluding "\r\n") and advances next past it
+        const char *lineEnd(const char *p, const char *end, const char *&next)
+        {
+            const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            next = nl ? nl + 1 : end;
+            const char *e = nl ? nl : end;
+            if (e > p && e[-1] == '\r')
+                --e;
+            return e;
+        }
+
+        bool isBlank(const char *b, const char *e)
+        {
+            return std::all_of(b, e, [](char c) { return c == ' ' || c == '\t'; });
+        }
+
+        std::string_view nextField(const char *&p, const char *e)
+        {
+            const char *tab = static_cast<const char *>(std::memchr(p, '\t', e - p));
+            const char *fieldEnd = tab ? tab : e;
+            std::string_view field(p, fieldEnd - p);
+            p = tab ? tab + 1 : e;
+            return field;
+        }
+    }
+
+    void loadFeatureTSV(const std::string &path, const std::string &target, Eigen::MatrixXd &X, Eigen::VectorXi &y)
+    {
+        MappedFile file(path);
+        file.advise(MADV_SEQUENTIAL);
+        const char *begin = file.data();
+        const char *end = begin + file.size();
+
+        // Column count from the first non-empty line; the last two fields are the labels
+        Eigen::Index fields = 0;
+        for (const char *p = begin, *next; p < end; p = next)
+        {
+            const char *e = lineEnd(p, end, next);
+            if (isBlank(p, e))
+                continue;
+            // Lines written by extract_features end with a tab before the labels, never after them
+            fields = std::count(p, e, '\t') + 1;
+            break;
+        }
+        if (fields < 3)
+            throw std::runtime_error(path + " has no feature columns");
+        const Eigen::Index cols = fields - 2;
+
+        // Newline-aligned chunks
+        const int nThreads = omp_get_max_threads();
+        const size_t nChunks = std::max<size_t>(1, std::max<size_t>(nThreads, file.size() / CHUNK_BYTES));
+        std::vector<Chunk> chunks;
+        chunks.reserve(nChunks);
+        const char *chunkBegin = begin;
+        for (size_t c = 1; c <= nChunks && chunkBegin < end; ++c)
+        {
+            const char *chunkEnd = end;
+            if (c < nChunks)
+            {
+                const char *guess = std::max(chunkBegin, begin + file.size() * c / nChunks);
+                const char *nl = static_cast<const char *>(std::memchr(guess, '\n', end - guess));
+                chunkEnd = nl ? nl + 1 : end;
+            }
+            chunks.push_back({chunkBegin, chunkEnd});
+            chunkBegin = chunkEnd;
+        }
+
+        // Pass 1: rows per chunk
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t c = 0; c < chunks.size(); ++c)
+        {
+            Eigen::Index rows = 0;
+            for (const char *p = chunks[c].begin, *next; p < chunks[c].end; p = next)
+            {
+                const char *e = lineEnd(p, chunks[c].end, next);
+                if (!isBlank(p, e))
+                    rows++;
+            }
+            chunks[c].rows = rows;
+        }
+
+        Eigen::Index totalRows = 0;
+        for (auto &chunk : chunks)
+        {
+            chunk.firstRow = totalRows;
+            totalRows += chunk.rows;
+        }
+
+        X.resize(totalRows, cols);
+        y.resize(totalRows);
+
+        // Pass 2: parse every chunk into its own row range
+        std::vector<std::string> errors(chunks.size());
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t c = 0; c < chunks.size(); ++c)
+        {
+            Eigen::Index row = chunks[c].firstRow;
+            for (const char *p = chunks[c].begin, *next; p < chunks[c].end && errors[c].empty(); p = next)
+            {
+                const char *e = lineEnd(p, chunks[c].end, next);
+                if (isBlank(p, e))
+                    continue;
+
+                const char *q = p;
+                for (Eigen::Index col = 0; col < cols; ++col)
+                {
+                    double value;
+                    auto [ptr, ec] = std::from_chars(q, e, value);
+                    if (ec != std::errc() || ptr == e || *ptr != '\t')
+                    {
+                        errors[c] = "malformed value in row " + std::to_string(row + 1) + ", column " + std::to_string(col + 1);
+                        break;
+                    }
+                    X(row, col) = value;
+                    q = ptr + 1;
+                }
+                if (!errors[c].empty())
+                    break;
+
+                std::string_view ageLabel = nextField(q, e);
+                std::string_view genderLabel = nextField(q, e);
+                if (ageLabel.empty() || genderLabel.empty())
+                {
+                    errors[c] = "missing labels in row " + std::to_string(row + 1);
+                    break;
+                }
+                y(row) = encodeTarget(ageLabel, genderLabel, target);
+                row++;
+            }
+        }
+
+        for (const auto &error : errors)
+            if (!error.empty())
+                throw std::runtime_error(path + ": " + error);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Dense>
+
+namespace harmony
+{
+
+	/**
+	 * @brief Loads a legacy feature TSV (features..., age label, gender label per line)
+	 * The file is memory-mapped and split into newline-aligned chunks that are
+	 * parsed in parallel with std::from_chars straight into the preallocated matrix.
+	 * @param path Path to the TSV file
+	 * @param target Prediction target passed to encodeTarget: "gender", "age" or "both"
+	 * @param X Output feature matrix (n_samples x n_features)
+	 * @param y Output class labels (n_samples)
+	 * @throws std::runtime_error on unreadable files or malformed lines
+	 */
+	void loadFeatureTSV(const std::string &path, const std::string &target, Eigen::MatrixXd &X, Eigen::VectorXi &y);
+
+}
@@ -1,9 +1,221 @@
 #include "chroma.h"
 #include "feature_utils.h"
+#include "stft.h"
+#include "../preprocessing/polyphase_resampler.hpp"
+#include "../../utils/simd.hpp"
 
 using namespace essentia;
 using namespace standard;
 
+namespace {
+    // Highest constant-Q bin, as a fraction of the sample rate (stays clear of Nyquist)
+    const float MAX_FREQUENCY_RATIO = 0.45f;
+}
+
+// Spectral kernels of every constant-Q bin, each restricted to the FFT bins where its
+// magnitude reaches threshold x its peak. Octaves whose full-length window does not fit
+// in a frame are analysed on the signal decimated by a power of two, where it does
+struct ChromaEngine::Kernel {
+    struct Bin {
+        int firstBin;
+        int pitchClass;
+        std::vector<float> re;
+        std::vector<float> im;
+    };
+    struct Level {
+        int decimation;
+        std::vector<Bin> bins;
+    };
+    std::vector<Level> levels;  // increasing decimation, the full-rate level first when present
+};
+
+namespace {
+    // Spectral kernel of one constant-Q bin at frequency (Hz) for a signal at sampleRate
+    ChromaEngine::Kernel::Bin buildBin(const StftEngine& stft, int frameSize, double sampleRate, double frequency,
+                                       double q, double a0, float threshold, std::vector<float>& magnitude) {
+        // Windowed complex exponential at frequency, centred in the frame; the real and
+        // imaginary parts go through the real FFT as two rows
+        const int fftBins = stft.getBins();
+        const int length = static_cast<int>(std::ceil(q * sampleRate / frequency));
+        const int offset = (frameSize - length) / 2;
+        float* real = stft.frame(0);
+        float* imag = stft.frame(1);
+        std::fill(real, real + frameSize, 0.0f);
+        std::fill(imag, imag + frameSize, 0.0f);
+        for (int n = 0; n < length; ++n) {
+            const double window = (a0 - (1.0 - a0) * std::cos(2.0 * M_PI * n / std::max(1, length - 1))) / length;
+            const double phase = 2.0 * M_PI * frequency * n / sampleRate;
+            real[offset + n] = static_cast<float>(window * std::cos(phase));
+            imag[offset + n] = static_cast<float>(window * std::sin(phase));
+        }
+        stft.execute(2);
+
+        // FFT(re + i im) = FFT(re) + i FFT(im) on the positive-frequency half
+        const float* r = stft.spectrum(0);
+        const float* i = stft.spectrum(1);
+        std::vector<float> re(fftBins), im(fftBins);
+        float peak = 0.0f;
+        for (int j = 0; j < fftBins; ++j) {
+            re[j] = r[2 * j] - i[2 * j + 1];
+            im[j] = r[2 * j + 1] + i[2 * j];
+            magnitude[j] = std::sqrt(re[j] * re[j] + im[j] * im[j]);
+            peak = std::max(peak, magnitude[j]);
+        }
+
+        int first = 0, last = fftBins - 1;
+        while (first < last && magnitude[first] < threshold * peak) ++first;
+        while (last > first && magnitude[last] < threshold * peak) --last;
+
+        // Conjugated and scaled by 1/N here, so a frame's bin is one complex dot product
+        ChromaEngine::Kernel::Bin bin;
+        bin.firstBin = first;
+        for (int j = first; j <= last; ++j) {
+            bin.re.push_back(re[j] / frameSize);
+            bin.im.push_back(-im[j] / frameSize);
+        }
+        return bin;
+    }
+
+    std::shared_ptr<const ChromaEngine::Kernel> buildKernel(int sampleRate, int frameSize, float minFrequency,
+                                                            int binsPerOctave, float threshold, const std::string& windowType) {
+        const double q = 1.0 / (std::pow(2.0, 1.0 / binsPerOctave) - 1.0);
+        const int octaves = static_cast<int>(std::floor(std::log2(MAX_FREQUENCY_RATIO * sampleRate / minFrequency)));
+        if (octaves < 1) {
+            throw std::invalid_argument("Chroma minFrequency leaves less than one octave below Nyquist");
+        }
+        // Even undecimated, the top of an octave has to stay below Nyquist of the rate
+        // its lowest bin needs
+        if (2.0 * q / MAX_FREQUENCY_RATIO > frameSize) {
+            throw std::invalid_argument("Chroma frameSize is too short for constant-Q analysis at this binsPerOctave");
+        }
+        const double a0 = windowType == "hamming" ? 0.54 : 0.5;
+
+        auto kernel = std::make_shared<ChromaEngine::Kernel>();
+        const StftEngine stft(frameSize);
+        std::vector<float> magnitude(stft.getBins());
+
+        // Highest octave first, so levels come out in increasing decimation
+        for (int octave = octaves - 1; octave >= 0; --octave) {
+            const double lowest = minFrequency * std::pow(2.0, octave);
+            int decimation = 1;
+            while (q * sampleRate / decimation / lowest > frameSize) decimation *= 2;
+            if (sampleRate % decimation != 0) {
+                throw std::invalid_argument("Chroma sample rate cannot be decimated by " + std::to_string(decimation) +
+                                            " for the octave at " + std::to_string(lowest) + " Hz");
+            }
+            if (kernel->levels.empty() || kernel->levels.back().decimation != decimation) {
+                kernel->levels.push_back({decimation, {}});
+            }
+
+            for (int b = 0; b < binsPerOctave; ++b) {
+                const double frequency = lowest * std::pow(2.0, static_cast<double>(b) / binsPerOctave);
+                ChromaEngine::Kernel::Bin bin = buildBin(stft, frameSize, static_cast<double>(sampleRate) / decimation,
+                                                         frequency, q, a0, threshold, magnitude);
+                bin.pitchClass = b;
+                kernel->levels.back().bins.push_back(std::move(bin));
+            }
+        }
+        return kernel;
+    }
+}
+
+ChromaEngine::ChromaEngine(int sampleRate, int frameSize, float minFrequency, int binsPerOctave,
+                           float threshold, const std::string& windowType)
+    : sampleRate(sampleRate), frameSize(frameSize), binsPerOctave(binsPerOctave) {
+    if (binsPerOctave < 12 || binsPerOctave % 12 != 0) {
+        throw std::invalid_argument("Chroma binsPerOctave must be a multiple of 12");
+    }
+    if (windowType != "hann" && windowType != "hamming") {
+        throw std::invalid_argument("Chroma windowType must be hann or hamming");
+    }
+
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const Kernel>> cache;
+    std::ostringstream key;
+    key << sampleRate << ':' << frameSize << ':' << minFrequency << ':' << binsPerOctave << ':' << threshold << ':' << windowType;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[key.str()];
+    if (!entry) {
+        entry = buildKernel(sampleRate, frameSize, minFrequency, binsPerOctave, threshold, windowType);
+    }
+    kernel = entry;
+}
+
+void ChromaEngine::compute(std::span<const float> audio, int hopSize, const ActivityMask* mask,
+                           std::vector<std::vector<float>>& chroma) const {
+    const StftEngine stft(frameSize);
+    const int fftBins = stft.getBins();
+    thread_local std::vector<float> xr, xi;
+    xr.resize(fftBins);
+    xi.resize(fftBins);
+
+    const std::vector<size_t> starts = StftEngine::frameStarts(audio.size(), frameSize, hopSize, mask);
+    if (starts.empty()) return;
+
+    // Halved rate by rate for the decimated levels, with half a frame of leading zeros so
+    // the frame centred on a full-rate frame's centre never starts before the signal
+    const size_t half = static_cast<size_t>(frameSize) / 2;
+    std::vector<std::vector<float>> decimated(kernel->levels.size());
+    std::vector<float> current;
+    int factor = 1;
+    for (size_t l = 0; l < kernel->levels.size(); ++l) {
+        const int decimation = kernel->levels[l].decimation;
+        if (decimation == 1) continue;
+        while (factor < decimation) {
+            const int rate = sampleRate / factor;
+            if (factor == 1) {
+                PolyphaseResampler::forRates(rate, rate / 2).process(audio, current);
+            } else {
+                current = PolyphaseResampler::forRates(rate, rate / 2).process(current);
+            }
+            factor *= 2;
+        }
+        decimated[l].assign(half, 0.0f);
+        decimated[l].insert(decimated[l].end(), current.begin(), current.end());
+    }
+
+    for (size_t blockStart = 0; blockStart < starts.size(); blockStart += StftEngine::BLOCK_FRAMES) {
+        const int count = static_cast<int>(std::min<size_t>(StftEngine::BLOCK_FRAMES, starts.size() - blockStart));
+        std::vector<std::vector<float>> block(count, std::vector<float>(binsPerOctave, 0.0f));
+
+        for (size_t l = 0; l < kernel->levels.size(); ++l) {
+            const Kernel::Level& level = kernel->levels[l];
+            // The kernels carry the analysis windows, so frames go in unwindowed
+            for (int f = 0; f < count; ++f) {
+                const size_t start = starts[blockStart + f];
+                if (level.decimation == 1) {
+                    stft.loadFrame(f, audio, start, nullptr);
+                } else {
+                    stft.loadFrame(f, decimated[l], (start + half) / level.decimation, nullptr);
+                }
+            }
+            stft.execute(count);
+
+            for (int f = 0; f < count; ++f) {
+                const float* x = stft.spectrum(f);
+                for (int j = 0; j < fftBins; ++j) {
+                    xr[j] = x[2 * j];
+                    xi[j] = x[2 * j + 1];
+                }
+
+                std::vector<float>& frameChroma = block[f];
+                for (const Kernel::Bin& bin : level.bins) {
+                    const int n = static_cast<int>(bin.re.size());
+                    const float* r = xr.data() + bin.firstBin;
+                    const float* i = xi.data() + bin.firstBin;
+                    const float real = harmony::dot(r, bin.re.data(), n) - harmony::dot(i, bin.im.data(), n);
+                    const float imag = harmony::dot(r, bin.im.data(), n) + harmony::dot(i, bin.re.data(), n);
+                    frameChroma[bin.pitchClass] += std::sqrt(real * real + imag * imag);
+                }
+            }
+        }
+
+        for (auto& frameChroma : block) {
+            chroma.push_back(std::move(frameChroma));
+        }
+    }
+}
+
 std::vector<Real> extractChromaFeatures(
     const std::string& filename,
     int sampleRate,
@@ -16,44 +228,40 @@ std::vector<Real> extractChromaFeatures(
     const std::string& windowType,
     AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity
 ) {
-    std::vector<Real> audioBuffer, frame, windowedFrame;
+    (void)factory;
+    std::vector<Real> loaded;
+    std::span<const Real> audioBuffer = inputAudio;
     if (inputAudio.empty()) {
         // Load audio file
-        Algorithm* loader = createAudioLoader(filename, sampleRate, audioBuffer);
-        if (audioBuffer.empty()) {
+        Algorithm* loader = createAudioLoader(filename, sampleRate, loaded);
+        if (loaded.empty()) {
             std::cerr << "Error loading audio file: " << filename << std::endl;
             return {};
         }
         delete loader;
-    } else {
-        audioBuffer = inputAudio;
+        audioBuffer = loaded;
     }
-    Algorithm* frameCutter = createFrameCutter(frameSize, hopSize, audioBuffer, frame);
-    Algorithm* windowing = createWindowing(frame, windowedFrame);
-
-    Algorithm* chroma = factory.create("Chromagram",
-        "sampleRate", sampleRate,
-        "minFrequency", minFrequency,
-        "binsPerOctave", binsPerOctave,
-        "threshold", threshold,
-        "normalizeType", normalizeType,
-        "windowType", windowType);
-
-    std::vector<Real> chromaCoeffs;
-    chroma->input("frame").set(windowedFrame);
-    chroma->output("chromagram").set(chromaCoeffs);
+    const ActivityMask* mask = prepareActiveRegion(audioBuffer, activity);
 
+    ChromaEngine engine(sampleRate, frameSize, minFrequency, binsPerOctave, threshold, windowType);
     std::vector<std::vector<Real>> allChroma;
-    while (true) {
-        frameCutter->compute();
-        if (frame.empty()) break;
+    engine.compute(audioBuffer, hopSize, mask, allChroma);
 
-        windowing->compute();
-        chroma->compute();
-        allChroma.push_back(chromaCoeffs);
+    // Per-frame normalisation, as Chromagram's normalizeType
+    for (auto& frame : allChroma) {
+        float scale = 0.0f;
+        if (normalizeType == "unit_max") {
+            scale = *std::max_element(frame.begin(), frame.end());
+        } else if (normalizeType == "unit_sum") {
+            scale = std::accumulate(frame.begin(), frame.end(), 0.0f);
+        }
+        if (scale > 0.0f) {
+            for (auto& value : frame) value /= scale;
+        }
     }
 
     std::vector<Real> meanChroma, stdChroma, finalVec;
@@ -63,12 +271,8 @@ std::vector<Real> extractChromaFeatures(
         finalVec.insert(finalVec.end(), stdChroma.begin(), stdChroma.end());
     }
 
-    delete frameCutter;
-    delete windowing;
-    delete chroma;
-
     if (appendToFeatureVector) {
         featureVector.insert(featureVector.end(), finalVec.begin(), finalVec.end());
     }
     return finalVec;
-}
\ No newline at end of file
+}
@@ -0,0 +1,115 @@
+#include "feature_cache.h"
+#include "../../utils/mapped_file.hpp"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char CACHE_MAGIC[4] = {'H', 'F', 'C', '1'};
+    const uint64_t FNV_PRIME = 1099511628211ull;
+}
+
+FeatureCache::FeatureCache(const std::string& directory, const std::string& settingsSignature)
+    : settingsHash_(hashBytes(settingsSignature.data(), settingsSignature.size())) {
+    fs::create_directories(directory);
+    const std::string path = (fs::path(directory) / "features.cache").string();
+
+    const bool exists = fs::exists(path) && fs::file_size(path) > 0;
+    if (exists) {
+        loadJournal(path);
+    }
+
+    journal_.open(path, std::ios::binary | std::ios::app);
+    if (!journal_.is_open()) {
+        throw std::runtime_error("Cannot open feature cache " + path);
+    }
+    if (!exists) {
+        journal_.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        journal_.flush();
+    }
+}
+
+uint64_t FeatureCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t FeatureCache::hashFile(const std::string& path) {
+    harmony::MappedFile file(path);
+    file.advise(MADV_SEQUENTIAL);
+    return hashBytes(file.data(), file.size());
+}
+
+void FeatureCache::loadJournal(const std::string& path) {
+    harmony::MappedFile file(path);
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    if (file.size() < sizeof(CACHE_MAGIC) || std::memcmp(p, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a feature cache");
+    }
+    p += sizeof(CACHE_MAGIC);
+
+    const size_t recordHeader = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+    while (static_cast<size_t>(end - p) >= recordHeader) {
+        uint64_t contentHash, settingsHash;
+        uint32_t n;
+        std::memcpy(&contentHash, p, sizeof(contentHash));
+        std::memcpy(&settingsHash, p + 8, sizeof(settingsHash));
+        std::memcpy(&n, p + 16, sizeof(n));
+        const size_t payload = static_cast<size_t>(n) * sizeof(float);
+        if (static_cast<size_t>(end - p) < recordHeader + payload) {
+            std::cerr << "Warning: ignoring truncated record at the end of " << path << std::endl;
+            break;
+        }
+        p += recordHeader;
+        if (settingsHash == settingsHash_) {
+            std::vector<float>& features = entries_[contentHash];
+            features.resize(n);
+            std::memcpy(features.data(), p, payload);
+        }
+        p += payload;
+    }
+
+    // Drop a partial trailing record so new appends stay aligned to record boundaries
+    const size_t validBytes = p - file.data();
+    if (validBytes < file.size()) {
+        file.close();
+        fs::resize_file(path, validBytes);
+    }
+}
+
+bool FeatureCache::lookup(uint64_t contentHash, std::vector<float>& features) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(contentHash);
+    if (it == entries_.end()) {
+        misses_++;
+        return false;
+    }
+    features = it->second;
+    hits_++;
+    return true;
+}
+
+void FeatureCache::store(uint64_t contentHash, const std::vector<float>& features) {
+    const uint32_t n = static_cast<uint32_t>(features.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[contentHash] = features;
+    journal_.write(reinterpret_cast<const char*>(&contentHash), sizeof(contentHash));
+    journal_.write(reinterpret_cast<const char*>(&settingsHash_), sizeof(settingsHash_));
+    journal_.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    journal_.write(reinterpret_cast<const char*>(features.data()), n * sizeof(float));
+    journal_.flush();
+}
+
+size_t FeatureCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
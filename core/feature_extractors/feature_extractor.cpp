@@ -1,31 +1,80 @@
 #include "feature_extractor.h"
+#include "feature_utils.h"
 
-std::vector<float> getFeatureVector(std::string path, std::vector<Real> inputAudio) {
-    int sampleRate = 16000;
+namespace {
+    // Families in FeatureSet order, so the vector lines up with featureNames()
+    void extractEnabled(const FeatureSet& set, std::span<const Real> audio, const ActivityMask* activity,
+                        AlgorithmFactory& factory, std::vector<float>& featureVector) {
+        if (set.mfcc.enabled) {
+            const FeatureSet::Mfcc& p = set.mfcc;
+            extractMFCCFeatures(
+                "", set.sampleRate, p.frameSize, p.hopSize, p.bands, p.coefficients,
+                p.lowFrequency, p.highFrequency, p.liftering, p.dctType, p.logType,
+                factory, featureVector, audio, true, activity
+            );
+        }
+        if (set.chroma.enabled) {
+            const FeatureSet::Chroma& p = set.chroma;
+            extractChromaFeatures(
+                "", set.sampleRate, p.frameSize, p.hopSize, p.minFrequency, p.binsPerOctave, p.threshold,
+                p.normalizeType, p.windowType, factory, featureVector, audio, true, activity
+            );
+        }
+        if (set.spectralContrast.enabled) {
+            const FeatureSet::SpectralContrast& p = set.spectralContrast;
+            extractSpectralContrastFeatures(
+                "", set.sampleRate, p.frameSize, p.hopSize, p.bands, p.lowFrequency, p.highFrequency,
+                p.neighbourRatio, p.staticDistribution, factory, featureVector, audio, true, activity
+            );
+        }
+        if (set.tonnetz.enabled) {
+            extractTonnetzFeatures("", set.sampleRate, factory, featureVector, audio, true, activity);
+        }
+        if (set.melSpectrogram.enabled) {
+            const FeatureSet::MelSpectrogram& p = set.melSpectrogram;
+            extractMelSpectrogramFeatures(
+                "", set.sampleRate, p.frameSize, p.hopSize, p.bands, p.lowFrequency, p.highFrequency,
+                p.warpingFormula, p.weighting, p.normalize, p.type, factory, featureVector, audio, true, activity
+            );
+        }
+    }
+}
 
-    AlgorithmFactory& factory = AlgorithmFactory::instance();
+MfccComparison validateMFCC(const FeatureSet& features, std::string path, std::vector<Real> inputAudio) {
+    std::vector<Real> audioBuffer = std::move(inputAudio);
+    if (audioBuffer.empty()) {
+        Algorithm* loader = createAudioLoader(path, features.sampleRate, audioBuffer);
+        delete loader;
+    }
+    const FeatureSet::Mfcc& p = features.mfcc;
+    return compareMFCCImplementations(
+        audioBuffer, features.sampleRate, p.frameSize, p.hopSize, p.bands, p.coefficients,
+        p.lowFrequency, p.highFrequency, p.liftering, p.logType, AlgorithmFactory::instance());
+}
 
-    std::vector<float> featureVector;
-    
-    std::vector<float> MFCCfeatures = extractMFCCFeatures(
-        path, sampleRate, 400, 160, 26, 26, 0, 8000, 22, 2, "dbamp", factory, featureVector, inputAudio,true
-    );
-
-    // std::vector<float> ChromaFeatures = extractChromaFeatures(
-    //     path, sampleRate, 32768, 16384, 27.5f, 36, 0.0f, "unit_max", "hann", factory, featureVector, inputAudio, true
-    // );
-
-    // std::vector<float> SpectralContrastFeatures = extractSpectralContrastFeatures(
-    //     path, sampleRate, 2048, 1024, 6, 20, 8000, 0.4f, 1.0f, factory, featureVector, inputAudio, true
-    // );
+std::vector<float> getFeatureVector(const FeatureSet& features, std::string path, std::vector<Real> inputAudio, const ActivityMask* activity) {
+    // Decoded once here rather than once per family
+    if (inputAudio.empty()) {
+        Algorithm* loader = createAudioLoader(path, features.sampleRate, inputAudio);
+        delete loader;
+        if (inputAudio.empty()) {
+            std::cerr << "Error loading audio file: " << path << std::endl;
+            return {};
+        }
+    }
+    return getFeatureVector(features, std::span<const Real>(inputAudio), activity);
+}
 
-    // std::vector<float> TonnetzFeatures = extractTonnetzFeatures(
-    //     path, sampleRate, factory, featureVector, inputAudio, true
-    // );
-
-    // std::vector<float> MelSpectrogramFeatures = extractMelSpectrogramFeatures(
-    //     path, sampleRate, 2048, 1024, 40, 20, 8000, "htkMel", "linear", "unit_sum", "power", factory, featureVector, inputAudio, true
-    // );
+std::vector<float> getFeatureVector(const FeatureSet& features, std::span<const Real> audio, const ActivityMask* activity) {
+    // Every extractor would fall back to decoding its (empty) path
+    if (audio.empty()) return {};
 
+    std::vector<float> featureVector;
+    extractEnabled(features, audio, activity, AlgorithmFactory::instance(), featureVector);
     return featureVector;
-}
\ No newline at end of file
+}
+
+std::vector<float> getFeatureVector(std::string path, std::vector<Real> inputAudio, const ActivityMask* activity) {
+    static const FeatureSet defaults;
+    return getFeatureVector(defaults, std::move(path), std::move(inputAudio), activity);
+}
@@ -0,0 +1,388 @@
+#include "feature_set.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Canonical family order: extraction, names and signatures all follow it
+    const char* const FAMILIES[] = {"mfcc", "chroma", "spectral_contrast", "tonnetz", "mel_spectrogram"};
+
+    std::string trim(std::string s) {
+        s.erase(0, s.find_first_not_of(" \t\r\n"));
+        s.erase(s.find_last_not_of(" \t\r\n") + 1);
+        return s;
+    }
+
+    void addStatNames(std::vector<std::string>& names, const std::string& prefix, int count) {
+        for (int i = 1; i <= count; i++) {
+            names.push_back(prefix + "_mean_" + std::to_string(i));
+        }
+        for (int i = 1; i <= count; i++) {
+            names.push_back(prefix + "_std_" + std::to_string(i));
+        }
+    }
+
+    // Every "<family>.<parameter>" key, bound to the field it sets
+    struct Field {
+        std::function<void(const std::string&)> parse;
+        std::function<std::string()> print;
+    };
+
+    template <typename T>
+    Field field(T& value) {
+        return {
+            [&value](const std::string& text) {
+                std::istringstream iss(text);
+                T parsed;
+                if (!(iss >> parsed) || !(iss >> std::ws).eof()) {
+                    throw std::invalid_argument(text);
+                }
+                value = parsed;
+            },
+            [&value]() {
+                std::ostringstream oss;
+                oss << value;
+                return oss.str();
+            }
+        };
+    }
+
+    // Ordered so save() writes the keys grouped by family
+    std::vector<std::pair<std::string, Field>> fieldsOf(FeatureSet& set) {
+        return {
+            {"sample_rate", field(set.sampleRate)},
+            {"activity", field(set.activity)},
+            {"mfcc.frame_size", field(set.mfcc.frameSize)},
+            {"mfcc.hop_size", field(set.mfcc.hopSize)},
+            {"mfcc.bands", field(set.mfcc.bands)},
+            {"mfcc.coefficients", field(set.mfcc.coefficients)},
+            {"mfcc.low_frequency", field(set.mfcc.lowFrequency)},
+            {"mfcc.high_frequency", field(set.mfcc.highFrequency)},
+            {"mfcc.liftering", field(set.mfcc.liftering)},
+            {"mfcc.dct_type", field(set.mfcc.dctType)},
+            {"mfcc.log_type", field(set.mfcc.logType)},
+            {"chroma.frame_size", field(set.chroma.frameSize)},
+            {"chroma.hop_size", field(set.chroma.hopSize)},
+            {"chroma.min_frequency", field(set.chroma.minFrequency)},
+            {"chroma.bins_per_octave", field(set.chroma.binsPerOctave)},
+            {"chroma.threshold", field(set.chroma.threshold)},
+            {"chroma.normalize_type", field(set.chroma.normalizeType)},
+            {"chroma.window_type", field(set.chroma.windowType)},
+            {"spectral_contrast.frame_size", field(set.spectralContrast.frameSize)},
+            {"spectral_contrast.hop_size", field(set.spectralContrast.hopSize)},
+            {"spectral_contrast.bands", field(set.spectralContrast.bands)},
+            {"spectral_contrast.low_frequency", field(set.spectralContrast.lowFrequency)},
+            {"spectral_contrast.high_frequency", field(set.spectralContrast.highFrequency)},
+            {"spectral_contrast.neighbour_ratio", field(set.spectralContrast.neighbourRatio)},
+            {"spectral_contrast.static_distribution", field(set.spectralContrast.staticDistribution)},
+            {"mel_spectrogram.frame_size", field(set.melSpectrogram.frameSize)},
+            {"mel_spectrogram.hop_size", field(set.melSpectrogram.hopSize)},
+            {"mel_spectrogram.bands", field(set.melSpectrogram.bands)},
+            {"mel_spectrogram.low_frequency", field(set.melSpectrogram.lowFrequency)},
+            {"mel_spectrogram.high_frequency", field(set.melSpectrogram.highFrequency)},
+            {"mel_spectrogram.warping_formula", field(set.melSpectrogram.warpingFormula)},
+            {"mel_spectrogram.weighting", field(set.melSpectrogram.weighting)},
+            {"mel_spectrogram.normalize", field(set.melSpectrogram.normalize)},
+            {"mel_spectrogram.type", field(set.melSpectrogram.type)},
+        };
+    }
+
+    // Rejects parameters the extractors cannot frame or filter with. Errors point at the line
+    // that set the value, or at the file when the default itself does not fit (e.g. a band
+    // edge above the Nyquist frequency of a lower sample rate). Disabled families are not checked
+    class Validator {
+    public:
+        Validator(const std::string& path, const std::map<std::string, int>& lineOf, int sampleRate)
+            : path(path), lineOf(lineOf), nyquist(sampleRate / 2.0f) {}
+
+        void positive(const std::string& key, double value) const {
+            if (value <= 0) fail(key, value, "must be positive");
+        }
+
+        // 0 <= low < high <= Nyquist
+        void band(const std::string& lowKey, float low, const std::string& highKey, float high) const {
+            if (low < 0) fail(lowKey, low, "must not be negative");
+            if (high > nyquist) fail(highKey, high, "is above the Nyquist frequency (" + format(nyquist) + " Hz)");
+            if (low >= high) fail(lowKey, low, "must be below " + highKey + " (" + format(high) + ")");
+        }
+
+        void atMost(const std::string& key, double value, const std::string& limitKey, double limit) const {
+            if (value > limit) fail(key, value, "must not exceed " + limitKey + " (" + format(limit) + ")");
+        }
+
+        [[noreturn]] void fail(const std::string& key, double value, const std::string& problem) const {
+            const auto it = lineOf.find(key);
+            const std::string where = it == lineOf.end() ? path : path + ":" + std::to_string(it->second);
+            throw std::runtime_error(where + ": " + key + "=" + format(value) + " " + problem);
+        }
+
+    private:
+        static std::string format(double value) {
+            std::ostringstream oss;
+            oss << value;
+            return oss.str();
+        }
+
+        const std::string& path;
+        const std::map<std::string, int>& lineOf;
+        float nyquist;
+    };
+
+    void validate(const FeatureSet& set, const std::string& path, const std::map<std::string, int>& lineOf) {
+        Validator check(path, lineOf, set.sampleRate);
+        check.positive("sample_rate", set.sampleRate);
+        if (set.mfcc.enabled) {
+            const FeatureSet::Mfcc& p = set.mfcc;
+            check.positive("mfcc.frame_size", p.frameSize);
+            check.positive("mfcc.hop_size", p.hopSize);
+            check.positive("mfcc.bands", p.bands);
+            check.positive("mfcc.coefficients", p.coefficients);
+            check.atMost("mfcc.coefficients", p.coefficients, "mfcc.bands", p.bands);
+            check.band("mfcc.low_frequency", p.lowFrequency, "mfcc.high_frequency", p.highFrequency);
+        }
+        // Tonnetz reads the chroma engine with its own fixed framing
+        if (set.chroma.enabled) {
+            const FeatureSet::Chroma& p = set.chroma;
+            check.positive("chroma.frame_size", p.frameSize);
+            check.positive("chroma.hop_size", p.hopSize);
+            check.positive("chroma.bins_per_octave", p.binsPerOctave);
+            check.positive("chroma.min_frequency", p.minFrequency);
+            check.atMost("chroma.min_frequency", p.minFrequency, "the Nyquist frequency", set.sampleRate / 2.0);
+        }
+        if (set.spectralContrast.enabled) {
+            const FeatureSet::SpectralContrast& p = set.spectralContrast;
+            check.positive("spectral_contrast.frame_size", p.frameSize);
+            check.positive("spectral_contrast.hop_size", p.hopSize);
+            check.positive("spectral_contrast.bands", p.bands);
+            check.band("spectral_contrast.low_frequency", p.lowFrequency, "spectral_contrast.high_frequency", p.highFrequency);
+        }
+        if (set.melSpectrogram.enabled) {
+            const FeatureSet::MelSpectrogram& p = set.melSpectrogram;
+            check.positive("mel_spectrogram.frame_size", p.frameSize);
+            check.positive("mel_spectrogram.hop_size", p.hopSize);
+            check.positive("mel_spectrogram.bands", p.bands);
+            check.band("mel_spectrogram.low_frequency", p.lowFrequency, "mel_spectrogram.high_frequency", p.highFrequency);
+        }
+    }
+
+    // Works on const and mutable sets alike
+    template <typename Set>
+    auto enabledFlag(Set& set, const std::string& family) -> decltype(&set.mfcc.enabled) {
+        if (family == "mfcc") return &set.mfcc.enabled;
+        if (family == "chroma") return &set.chroma.enabled;
+        if (family == "spectral_contrast") return &set.spectralContrast.enabled;
+        if (family == "tonnetz") return &set.tonnetz.enabled;
+        if (family == "mel_spectrogram") return &set.melSpectrogram.enabled;
+        return nullptr;
+    }
+}
+
+FeatureSet FeatureSet::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open feature set " + path);
+    }
+
+    FeatureSet set;
+    std::map<std::string, Field> fields;
+    for (auto& [key, f] : fieldsOf(set)) fields.emplace(key, std::move(f));
+
+    std::map<std::string, int> lineOf;
+    std::string line;
+    bool sawFamilies = false;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        const auto pos = line.find('=');
+        const std::string where = path + ":" + std::to_string(lineNumber);
+        if (pos == std::string::npos) {
+            throw std::runtime_error(where + ": expected key=value");
+        }
+        const std::string key = trim(line.substr(0, pos));
+        const std::string value = trim(line.substr(pos + 1));
+        lineOf[key] = lineNumber;
+
+        if (key == "version") {
+            int version = 0;
+            field(version).parse(value);
+            if (version > VERSION) {
+                throw std::runtime_error(where + ": feature set version " + value + " is newer than this build (" + std::to_string(VERSION) + ")");
+            }
+        } else if (key == "families") {
+            sawFamilies = true;
+            for (const char* family : FAMILIES) *enabledFlag(set, family) = false;
+            std::istringstream families(value);
+            std::string family;
+            while (std::getline(families, family, ',')) {
+                bool* flag = enabledFlag(set, trim(family));
+                if (!flag) {
+                    throw std::runtime_error(where + ": unknown feature family '" + trim(family) + "'");
+                }
+                *flag = true;
+            }
+        } else {
+            auto it = fields.find(key);
+            if (it == fields.end()) {
+                throw std::runtime_error(where + ": unknown key '" + key + "'");
+            }
+            try {
+                it->second.parse(value);
+            } catch (const std::invalid_argument&) {
+                throw std::runtime_error(where + ": invalid value '" + value + "' for " + key);
+            }
+            if (key == "activity" && set.activity != "none" && set.activity != "mask") {
+                throw std::runtime_error(where + ": activity must be 'none' or 'mask'");
+            }
+        }
+    }
+
+    if (!sawFamilies || set.describe().empty()) {
+        throw std::runtime_error(path + ": no feature families selected");
+    }
+    validate(set, path, lineOf);
+    return set;
+}
+
+FeatureSet FeatureSet::forModel(const std::string& modelDir) {
+    const std::filesystem::path path = std::filesystem::path(modelDir) / FILE_NAME;
+    if (!std::filesystem::exists(path)) {
+        return FeatureSet();
+    }
+    return load(path.string());
+}
+
+void FeatureSet::save(const std::string& path) const {
+    std::ofstream file(path);
+    file << "# Harmony feature set\n";
+    file << "version=" << VERSION << "\n";
+    file << "families=";
+    std::string families = describe();
+    std::replace(families.begin(), families.end(), '+', ',');
+    file << families << "\n";
+
+    // Fields bind mutable references; printing through a copy leaves this untouched
+    FeatureSet copy = *this;
+    for (auto& [key, f] : fieldsOf(copy)) {
+        file << key << "=" << f.print() << "\n";
+    }
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Failed to write feature set " + path);
+    }
+}
+
+std::string FeatureSet::signature() const {
+    // The MFCC part keeps the layout of the former featureConfigSignature, so caches
+    // written for MFCC-only extraction stay valid
+    std::ostringstream oss;
+    bool first = true;
+    auto separate = [&]() {
+        if (!first) oss << ";";
+        first = false;
+    };
+    if (mfcc.enabled) {
+        separate();
+        oss << "mfcc:sr=" << sampleRate
+            << ",frame=" << mfcc.frameSize
+            << ",hop=" << mfcc.hopSize
+            << ",bands=" << mfcc.bands
+            << ",coeffs=" << mfcc.coefficients
+            << ",lo=" << mfcc.lowFrequency
+            << ",hi=" << mfcc.highFrequency
+            << ",lifter=" << mfcc.liftering
+            << ",dct=" << mfcc.dctType
+            << ",log=" << mfcc.logType
+            << ",kernel=native"
+            << ",stats=mean+std"
+            << ",padding=skip";
+    }
+    if (chroma.enabled) {
+        separate();
+        oss << "chroma:sr=" << sampleRate
+            << ",frame=" << chroma.frameSize
+            << ",hop=" << chroma.hopSize
+            << ",min=" << chroma.minFrequency
+            << ",bins=" << chroma.binsPerOctave
+            << ",threshold=" << chroma.threshold
+            << ",norm=" << chroma.normalizeType
+            << ",window=" << chroma.windowType
+            << ",kernel=cq-multirate";
+    }
+    if (spectralContrast.enabled) {
+        separate();
+        oss << "spectral_contrast:sr=" << sampleRate
+            << ",frame=" << spectralContrast.frameSize
+            << ",hop=" << spectralContrast.hopSize
+            << ",bands=" << spectralContrast.bands
+            << ",lo=" << spectralContrast.lowFrequency
+            << ",hi=" << spectralContrast.highFrequency
+            << ",neighbour=" << spectralContrast.neighbourRatio
+            << ",static=" << spectralContrast.staticDistribution;
+    }
+    if (tonnetz.enabled) {
+        separate();
+        oss << "tonnetz:sr=" << sampleRate << ",centroid=6,kernel=cq-multirate";
+    }
+    if (melSpectrogram.enabled) {
+        separate();
+        oss << "mel_spectrogram:sr=" << sampleRate
+            << ",frame=" << melSpectrogram.frameSize
+            << ",hop=" << melSpectrogram.hopSize
+            << ",bands=" << melSpectrogram.bands
+            << ",lo=" << melSpectrogram.lowFrequency
+            << ",hi=" << melSpectrogram.highFrequency
+            << ",warping=" << melSpectrogram.warpingFormula
+            << ",weighting=" << melSpectrogram.weighting
+            << ",norm=" << melSpectrogram.normalize
+            << ",type=" << melSpectrogram.type;
+    }
+    // Unmasked sets keep their former signature
+    if (activity != "none") {
+        separate();
+        oss << "activity=" << activity;
+    }
+    return oss.str();
+}
+
+std::string FeatureSet::describe() const {
+    std::string families;
+    for (const char* family : FAMILIES) {
+        if (!*enabledFlag(*this, family)) continue;
+        if (!families.empty()) families += "+";
+        families += family;
+    }
+    return families;
+}
+
+std::vector<std::string> FeatureSet::featureNames() const {
+    std::vector<std::string> names;
+    if (mfcc.enabled) {
+        addStatNames(names, "mfcc", mfcc.coefficients);
+    }
+    if (chroma.enabled) {
+        addStatNames(names, "chroma", chroma.binsPerOctave);
+    }
+    if (spectralContrast.enabled) {
+        // Peaks then valleys per frame, so the means and stddevs each come in two halves
+        for (const char* stat : {"mean", "std"}) {
+            for (const char* part : {"peak", "valley"}) {
+                for (int i = 1; i <= spectralContrast.bands; i++) {
+                    names.push_back(std::string("spectral_") + part + "_" + stat + "_" + std::to_string(i));
+                }
+            }
+        }
+    }
+    if (tonnetz.enabled) {
+        addStatNames(names, "tonnetz", 6);
+    }
+    if (melSpectrogram.enabled) {
+        addStatNames(names, "mel", melSpectrogram.bands);
+    }
+    return names;
+}
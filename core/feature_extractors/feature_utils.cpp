@@ -1,4 +1,5 @@
 #include "feature_utils.h"
+#include "../audio/wav_reader.hpp"
 
 using namespace essentia;
 using namespace standard;
@@ -12,6 +13,14 @@ void shutdownEssentia() {
 }
 
 Algorithm* createAudioLoader(const std::string& filename, int sampleRate, std::vector<Real>& audioBuffer) {
+    // WAV files already at the requested rate need no decoder or resampler, so no loader is created
+    WavInfo info;
+    int wavSampleRate = 0;
+    if (WavReader::probe(filename, info) && info.sampleRate == sampleRate &&
+        WavReader::read(filename, audioBuffer, wavSampleRate)) {
+        return nullptr;
+    }
+
     AlgorithmFactory& factory = AlgorithmFactory::instance();
     Algorithm* loader = factory.create("MonoLoader", "filename", filename, "sampleRate", sampleRate);
     loader->output("audio").set(audioBuffer);
@@ -38,6 +47,24 @@ Algorithm* createWindowing(const std::vector<Real>& frame, std::vector<Real>& wi
     return windowing;
 }
 
+const ActivityMask* prepareActiveRegion(std::span<const Real>& audio, const ActivityMask* activity) {
+    size_t validSamples = audio.size();
+    if (activity && !activity->empty()) {
+        validSamples = std::min(validSamples, activity->validSamples);
+    } else {
+        while (validSamples > 0 && audio[validSamples - 1] == 0.0f) validSamples--;
+    }
+
+    // An all-silent clip keeps its samples so every extractor still produces a full vector
+    if (validSamples == 0) return nullptr;
+    audio = audio.first(validSamples);
+
+    if (!activity || activity->empty()) return nullptr;
+    const bool anyActive = std::any_of(activity->active.begin(), activity->active.end(),
+                                       [](uint8_t a) { return a != 0; });
+    return anyActive ? activity : nullptr;
+}
+
 void computeStats(const std::vector<std::vector<Real>>& features,
                 std::vector<Real>& means,
                 std::vector<Real>& stddevs) {
@@ -1,5 +1,6 @@
 #include "mel_spectrogram.h"
 #include "feature_utils.h"
+#include "stft.h"
 
 using namespace essentia;
 using namespace standard;
@@ -18,29 +19,29 @@ std::vector<Real> extractMelSpectrogramFeatures(
     const std::string& type,
     AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity
 ) {
-    std::vector<Real> audioBuffer, frame, windowedFrame;
+    std::vector<Real> loaded;
+    std::span<const Real> audioBuffer = inputAudio;
     if(inputAudio.empty()) {
         // Load audio file
-        Algorithm* loader = createAudioLoader(filename, sampleRate, audioBuffer);
-        if (audioBuffer.empty()) {
+        Algorithm* loader = createAudioLoader(filename, sampleRate, loaded);
+        if (loaded.empty()) {
             std::cerr << "Error loading audio file: " << filename << std::endl;
             return {};
         }
         delete loader;
-    } else {
-        audioBuffer = inputAudio;
+        audioBuffer = loaded;
     }
 
-    Algorithm* frameCutter = createFrameCutter(frameSize, hopSize, audioBuffer, frame);
-    Algorithm* windowing = createWindowing(frame, windowedFrame);
+    const ActivityMask* mask = prepareActiveRegion(audioBuffer, activity);
 
-    Algorithm* spectrum = factory.create("Spectrum", "size", frameSize);
-    std::vector<Real> spectrumFrame;
-    spectrum->input("frame").set(windowedFrame);
-    spectrum->output("spectrum").set(spectrumFrame);
+    // Magnitude spectra come from the batched STFT, a block of frames per FFT call
+    const StftEngine stft(frameSize);
+    const std::vector<Real> window = StftEngine::hannWindow(frameSize);
+    std::vector<Real> spectrumFrame(stft.getBins());
 
     Algorithm* melBands = factory.create("MelBands",
         "sampleRate", sampleRate,
@@ -57,14 +58,19 @@ std::vector<Real> extractMelSpectrogramFeatures(
     melBands->output("bands").set(melBandsFrame);
 
     std::vector<std::vector<Real>> allMelBands;
-    while (true) {
-        frameCutter->compute();
-        if (frame.empty()) break;
+    const std::vector<size_t> starts = StftEngine::frameStarts(audioBuffer.size(), frameSize, hopSize, mask);
+    for (size_t blockStart = 0; blockStart < starts.size(); blockStart += StftEngine::BLOCK_FRAMES) {
+        const int count = static_cast<int>(std::min<size_t>(StftEngine::BLOCK_FRAMES, starts.size() - blockStart));
+        for (int f = 0; f < count; ++f) {
+            stft.loadFrame(f, audioBuffer, starts[blockStart + f], window.data());
+        }
+        stft.execute(count);
 
-        windowing->compute();
-        spectrum->compute();
-        melBands->compute();
-        allMelBands.push_back(melBandsFrame);
+        for (int f = 0; f < count; ++f) {
+            stft.magnitudeSpectrum(f, spectrumFrame.data());
+            melBands->compute();
+            allMelBands.push_back(melBandsFrame);
+        }
     }
 
     std::vector<Real> meanMelBands, stdMelBands, finalVec;
@@ -74,9 +80,6 @@ std::vector<Real> extractMelSpectrogramFeatures(
         finalVec.insert(finalVec.end(), stdMelBands.begin(), stdMelBands.end());
     }
 
-    delete frameCutter;
-    delete windowing;
-    delete spectrum;
     delete melBands;
 
     if (appendToFeatureVector) {
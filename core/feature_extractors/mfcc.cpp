@@ -1,11 +1,12 @@
 #include "mfcc.h"
+#include "mfcc_kernel.h"
 #include "feature_utils.h"
 
 using namespace essentia;
 using namespace standard;
 
-std::vector<Real> extractMFCCFeatures(
-    const std::string& filename,
+std::vector<std::vector<Real>> computeMFCCFramesEssentia(
+    std::span<const Real> audio,
     int sampleRate,
     int frameSize,
     int hopSize,
@@ -17,24 +18,11 @@ std::vector<Real> extractMFCCFeatures(
     int dctType,
     const std::string& logType,
     AlgorithmFactory& factory,
-    std::vector<float>& featureVector,
-    std::vector<Real> inputAudio,
-    bool appendToFeatureVector
+    const ActivityMask* mask
 ) {
-    std::vector<Real> audioBuffer, frame, windowedFrame;
-
-    if(inputAudio.empty()) {
-        // Load audio file
-        Algorithm* loader = createAudioLoader(filename, sampleRate, audioBuffer);
-        if (audioBuffer.empty()) {
-            std::cerr << "Error loading audio file: " << filename << std::endl;
-            return {};
-        }
-        delete loader;
-    } else {
-        audioBuffer = inputAudio;
-    }
-
+    // FrameCutter only reads std::vector inputs
+    const std::vector<Real> audioBuffer(audio.begin(), audio.end());
+    std::vector<Real> frame, windowedFrame;
     Algorithm* frameCutter = createFrameCutter(frameSize, hopSize, audioBuffer, frame);
     Algorithm* windowing = createWindowing(frame, windowedFrame);
 
@@ -61,16 +49,112 @@ std::vector<Real> extractMFCCFeatures(
     mfcc->output("bands").set(mfccBands);
 
     std::vector<std::vector<Real>> allMFCCs;
+    size_t frameIndex = 0;
     while (true) {
         frameCutter->compute();
         if (frame.empty()) break;
 
+        const size_t frameStart = frameIndex++ * hopSize;
+        if (mask && !mask->isActive(frameStart, frameSize)) continue;
+
         windowing->compute();
         spectrum->compute();
         mfcc->compute();
         allMFCCs.push_back(mfccCoeffs);
     }
 
+    delete frameCutter;
+    delete windowing;
+    delete spectrum;
+    delete mfcc;
+    return allMFCCs;
+}
+
+MfccComparison compareMFCCImplementations(
+    std::span<const Real> audio,
+    int sampleRate,
+    int frameSize,
+    int hopSize,
+    int numberBands,
+    int numberCoefficients,
+    float lowFrequencyBound,
+    float highFrequencyBound,
+    int liftering,
+    const std::string& logType,
+    AlgorithmFactory& factory
+) {
+    std::span<const Real> audioBuffer = audio;
+    prepareActiveRegion(audioBuffer, nullptr);
+
+    std::vector<std::vector<Real>> native;
+    MfccKernel kernel(sampleRate, frameSize, numberBands, numberCoefficients,
+                      lowFrequencyBound, highFrequencyBound, liftering, logType);
+    kernel.compute(audioBuffer, hopSize, nullptr, native);
+    std::vector<std::vector<Real>> reference = computeMFCCFramesEssentia(
+        audioBuffer, sampleRate, frameSize, hopSize, numberBands, numberCoefficients,
+        lowFrequencyBound, highFrequencyBound, liftering, 2, logType, factory, nullptr);
+
+    MfccComparison comparison;
+    comparison.nativeFrames = native.size();
+    comparison.referenceFrames = reference.size();
+    double totalError = 0.0;
+    size_t values = 0;
+    for (size_t f = 0; f < std::min(native.size(), reference.size()); ++f) {
+        for (size_t i = 0; i < std::min(native[f].size(), reference[f].size()); ++i) {
+            const float error = std::abs(native[f][i] - reference[f][i]);
+            comparison.maxAbsError = std::max(comparison.maxAbsError, error);
+            totalError += error;
+            ++values;
+        }
+    }
+    comparison.meanAbsError = values ? static_cast<float>(totalError / values) : 0.0f;
+    return comparison;
+}
+
+std::vector<Real> extractMFCCFeatures(
+    const std::string& filename,
+    int sampleRate,
+    int frameSize,
+    int hopSize,
+    int numberBands,
+    int numberCoefficients,
+    float lowFrequencyBound,
+    float highFrequencyBound,
+    int liftering,
+    int dctType,
+    const std::string& logType,
+    AlgorithmFactory& factory,
+    std::vector<float>& featureVector,
+    std::span<const Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity
+) {
+    std::vector<Real> loaded;
+    std::span<const Real> audioBuffer = inputAudio;
+
+    if(inputAudio.empty()) {
+        // Load audio file
+        Algorithm* loader = createAudioLoader(filename, sampleRate, loaded);
+        if (loaded.empty()) {
+            std::cerr << "Error loading audio file: " << filename << std::endl;
+            return {};
+        }
+        delete loader;
+        audioBuffer = loaded;
+    }
+
+    const ActivityMask* mask = prepareActiveRegion(audioBuffer, activity);
+
+    std::vector<std::vector<Real>> allMFCCs;
+    if (MfccKernel::supports(dctType, logType)) {
+        MfccKernel kernel(sampleRate, frameSize, numberBands, numberCoefficients,
+                          lowFrequencyBound, highFrequencyBound, liftering, logType);
+        kernel.compute(audioBuffer, hopSize, mask, allMFCCs);
+    } else {
+        allMFCCs = computeMFCCFramesEssentia(audioBuffer, sampleRate, frameSize, hopSize, numberBands, numberCoefficients,
+                                             lowFrequencyBound, highFrequencyBound, liftering, dctType, logType, factory, mask);
+    }
+
     std::vector<Real> meanMFCCs, stdMFCCs, finalVec;
     if (!allMFCCs.empty()) {
         computeStats(allMFCCs, meanMFCCs, stdMFCCs);
@@ -78,11 +162,6 @@ std::vector<Real> extractMFCCFeatures(
         finalVec.insert(finalVec.end(), stdMFCCs.begin(), stdMFCCs.end());
     }
 
-    delete frameCutter;
-    delete windowing;
-    delete spectrum;
-    delete mfcc;
-
     if (appendToFeatureVector) {
         featureVector.insert(featureVector.end(), finalVec.begin(), finalVec.end());
     }
@@ -0,0 +1,218 @@
+#include "mfcc_kernel.h"
+#include "stft.h"
+#include "../../utils/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Frames transformed and reduced together
+    const int BLOCK_FRAMES = StftEngine::BLOCK_FRAMES;
+    // Essentia's silence cutoff: band energies below it are clamped before the log
+    const float SILENCE_CUTOFF = 1e-10f;
+
+    float hz2mel(float hz) { return 2595.0f * std::log10(1.0f + hz / 700.0f); }
+    float mel2hz(float mel) { return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f); }
+
+#if defined(__SSE2__)
+    // Natural log of four positive, normal floats (Cephes logf polynomial, ~1 ulp)
+    __m128 log4(__m128 x) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128i e = _mm_srli_epi32(_mm_castps_si128(x), 23);
+        x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000)));
+        x = _mm_or_ps(x, _mm_set1_ps(0.5f));
+        e = _mm_sub_epi32(e, _mm_set1_epi32(0x7f));
+        __m128 exponent = _mm_add_ps(_mm_cvtepi32_ps(e), one);
+
+        // Keep the mantissa in [sqrt(1/2), sqrt(2))
+        const __m128 small = _mm_cmplt_ps(x, _mm_set1_ps(0.707106781186547524f));
+        const __m128 tmp = _mm_and_ps(x, small);
+        x = _mm_sub_ps(x, one);
+        exponent = _mm_sub_ps(exponent, _mm_and_ps(one, small));
+        x = _mm_add_ps(x, tmp);
+
+        const __m128 z = _mm_mul_ps(x, x);
+        __m128 y = _mm_set1_ps(7.0376836292e-2f);
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.1514610310e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.1676998740e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.2420140846e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.4249322787e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.6668057665e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(2.0000714765e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-2.4999993993e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(3.3333331174e-1f));
+        y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+        y = _mm_add_ps(y, _mm_mul_ps(exponent, _mm_set1_ps(-2.12194440e-4f)));
+        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        x = _mm_add_ps(x, y);
+        return _mm_add_ps(x, _mm_mul_ps(exponent, _mm_set1_ps(0.693359375f)));
+    }
+#endif
+
+    // values[i] = scale * ln(max(values[i], SILENCE_CUTOFF))
+    void compressLog(float* values, size_t n, float scale) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128 floor4 = _mm_set1_ps(SILENCE_CUTOFF);
+        const __m128 scale4 = _mm_set1_ps(scale);
+        for (; i + 4 <= n; i += 4) {
+            const __m128 v = _mm_max_ps(_mm_loadu_ps(values + i), floor4);
+            _mm_storeu_ps(values + i, _mm_mul_ps(log4(v), scale4));
+        }
+#endif
+        for (; i < n; ++i) {
+            values[i] = scale * std::log(std::max(values[i], SILENCE_CUTOFF));
+        }
+    }
+
+    // y[i] += a * x[i]
+    void axpy(float a, const float* x, float* y, int n) {
+        int i = 0;
+#if defined(__AVX__)
+        const __m256 a8 = _mm256_set1_ps(a);
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(a8, _mm256_loadu_ps(x + i))));
+#endif
+#if defined(__SSE2__)
+        const __m128 a4 = _mm_set1_ps(a);
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a4, _mm_loadu_ps(x + i))));
+#endif
+        for (; i < n; ++i)
+            y[i] += a * x[i];
+    }
+}
+
+MfccKernel::MfccKernel(int sampleRate, int frameSize, int numberBands, int numberCoefficients,
+                       float lowFrequencyBound, float highFrequencyBound, int liftering,
+                       const std::string& logType)
+    : frameSize(frameSize), bins(frameSize / 2 + 1), numberBands(numberBands), numberCoefficients(numberCoefficients) {
+    if (frameSize < 2 || frameSize % 2 != 0) {
+        throw std::invalid_argument("MfccKernel frame size must be even");
+    }
+    if (!supports(2, logType)) {
+        throw std::invalid_argument("MfccKernel does not support logType " + logType);
+    }
+    logScale = logType == "dbamp" ? static_cast<float>(20.0 / M_LN10)
+             : logType == "dbpow" ? static_cast<float>(10.0 / M_LN10)
+             : 1.0f;
+
+    // Windowing's zero-phase rotation only changes the phase of the spectrum, which the
+    // power spectrum discards
+    window = StftEngine::hannWindow(frameSize);
+
+    // Triangles equally spaced on the HTK mel scale, weighted in mel ("warping") and
+    // normalised to unit sum; only the non-zero bin range of each filter is stored
+    std::vector<float> edges(numberBands + 2);
+    const float lowMel = hz2mel(lowFrequencyBound);
+    const float highMel = hz2mel(highFrequencyBound);
+    for (int i = 0; i < numberBands + 2; ++i) {
+        edges[i] = mel2hz(lowMel + (highMel - lowMel) * i / (numberBands + 1));
+    }
+    const float binWidth = (sampleRate / 2.0f) / (bins - 1);
+    filters.resize(numberBands);
+    for (int band = 0; band < numberBands; ++band) {
+        const float lowerMel = hz2mel(edges[band]);
+        const float centreMel = hz2mel(edges[band + 1]);
+        const float upperMel = hz2mel(edges[band + 2]);
+        const int first = std::max(0, static_cast<int>(edges[band] / binWidth + 0.5f));
+        const int last = std::min(bins, static_cast<int>(edges[band + 2] / binWidth + 0.5f));
+
+        MelFilter& filter = filters[band];
+        filter.firstBin = first;
+        filter.weights.assign(std::max(0, last - first), 0.0f);
+        float sum = 0.0f;
+        for (int j = first; j < last; ++j) {
+            const float hz = j * binWidth;
+            float weight = 0.0f;
+            if (hz >= edges[band] && hz < edges[band + 1]) {
+                weight = (hz2mel(hz) - lowerMel) / (centreMel - lowerMel);
+            } else if (hz >= edges[band + 1] && hz < edges[band + 2]) {
+                weight = (upperMel - hz2mel(hz)) / (upperMel - centreMel);
+            }
+            filter.weights[j - first] = weight;
+            sum += weight;
+        }
+        if (sum > 0.0f) {
+            for (float& weight : filter.weights) weight /= sum;
+        }
+    }
+
+    // Orthonormal DCT-II with the sinusoidal lifter applied to each output row
+    dct.resize(static_cast<size_t>(numberCoefficients) * numberBands);
+    for (int i = 0; i < numberCoefficients; ++i) {
+        const double scale = i == 0 ? 1.0 / std::sqrt(static_cast<double>(numberBands))
+                                    : std::sqrt(2.0 / numberBands);
+        const double lifter = (i > 0 && liftering > 0) ? 1.0 + (liftering / 2.0) * std::sin(M_PI * i / liftering) : 1.0;
+        for (int m = 0; m < numberBands; ++m) {
+            dct[static_cast<size_t>(i) * numberBands + m] =
+                static_cast<float>(lifter * scale * std::cos(M_PI / numberBands * i * (m + 0.5)));
+        }
+    }
+}
+
+bool MfccKernel::supports(int dctType, const std::string& logType) {
+    return dctType == 2 && (logType == "dbamp" || logType == "dbpow" || logType == "log");
+}
+
+void MfccKernel::compute(std::span<const float> audio, int hopSize, const ActivityMask* mask,
+                         std::vector<std::vector<float>>& mfccs) const {
+    if (audio.empty() || hopSize <= 0) return;
+
+    const StftEngine stft(frameSize);
+    thread_local std::vector<float> power, bands, cepstra;
+    power.resize(static_cast<size_t>(bins) * BLOCK_FRAMES);
+    bands.resize(static_cast<size_t>(numberBands) * BLOCK_FRAMES);
+    cepstra.resize(static_cast<size_t>(numberCoefficients) * BLOCK_FRAMES);
+
+    const std::vector<size_t> starts = StftEngine::frameStarts(audio.size(), frameSize, hopSize, mask);
+    for (size_t blockStart = 0; blockStart < starts.size(); blockStart += BLOCK_FRAMES) {
+        const int count = static_cast<int>(std::min<size_t>(BLOCK_FRAMES, starts.size() - blockStart));
+
+        // Cut and window every frame of the block, then transform them together
+        for (int f = 0; f < count; ++f) {
+            stft.loadFrame(f, audio, starts[blockStart + f], window.data());
+        }
+        stft.execute(count);
+
+        // Power spectra, one row per frame
+        for (int f = 0; f < count; ++f) {
+            stft.powerSpectrum(f, power.data() + static_cast<size_t>(f) * bins);
+        }
+
+        // Sparse mel weights x power spectra, stored band-major for the DCT below
+        for (int f = 0; f < count; ++f) {
+            const float* spectrum = power.data() + static_cast<size_t>(f) * bins;
+            for (int band = 0; band < numberBands; ++band) {
+                const MelFilter& filter = filters[band];
+                bands[static_cast<size_t>(band) * BLOCK_FRAMES + f] =
+                    harmony::dot(filter.weights.data(), spectrum + filter.firstBin, static_cast<int>(filter.weights.size()));
+            }
+        }
+        for (int band = 0; band < numberBands; ++band) {
+            compressLog(bands.data() + static_cast<size_t>(band) * BLOCK_FRAMES, count, logScale);
+        }
+
+        // DCT of the whole block as (coefficients x bands) x (bands x frames)
+        std::fill(cepstra.begin(), cepstra.end(), 0.0f);
+        for (int i = 0; i < numberCoefficients; ++i) {
+            float* out = cepstra.data() + static_cast<size_t>(i) * BLOCK_FRAMES;
+            for (int band = 0; band < numberBands; ++band) {
+                axpy(dct[static_cast<size_t>(i) * numberBands + band], bands.data() + static_cast<size_t>(band) * BLOCK_FRAMES, out, count);
+            }
+        }
+
+        for (int f = 0; f < count; ++f) {
+            std::vector<float> coefficients(numberCoefficients);
+            for (int i = 0; i < numberCoefficients; ++i) {
+                coefficients[i] = cepstra[static_cast<size_t>(i) * BLOCK_FRAMES + f];
+            }
+            mfccs.push_back(std::move(coefficients));
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "spectral_contrast.h"
 #include "feature_utils.h"
+#include "stft.h"
 
 using namespace essentia;
 using namespace standard;
@@ -16,28 +17,28 @@ std::vector<Real> extractSpectralContrastFeatures(
     float staticDistribution,
     AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity
 ) {
-    std::vector<Real> audioBuffer, frame, windowedFrame;
+    std::vector<Real> loaded;
+    std::span<const Real> audioBuffer = inputAudio;
     if(inputAudio.empty()) {
         // Load audio file
-        Algorithm* loader = createAudioLoader(filename, sampleRate, audioBuffer);
-        if (audioBuffer.empty()) {
+        Algorithm* loader = createAudioLoader(filename, sampleRate, loaded);
+        if (loaded.empty()) {
             std::cerr << "Error loading audio file: " << filename << std::endl;
             return {};
         }
         delete loader;
-    } else {
-        audioBuffer = inputAudio;
+        audioBuffer = loaded;
     }
-    Algorithm* frameCutter = createFrameCutter(frameSize, hopSize, audioBuffer, frame);
-    Algorithm* windowing = createWindowing(frame, windowedFrame);
+    const ActivityMask* mask = prepareActiveRegion(audioBuffer, activity);
 
-    Algorithm* spectrum = factory.create("Spectrum", "size", frameSize);
-    std::vector<Real> spectrumFrame;
-    spectrum->input("frame").set(windowedFrame);
-    spectrum->output("spectrum").set(spectrumFrame);
+    // Magnitude spectra come from the batched STFT, a block of frames per FFT call
+    const StftEngine stft(frameSize);
+    const std::vector<Real> window = StftEngine::hannWindow(frameSize);
+    std::vector<Real> spectrumFrame(stft.getBins());
 
     Algorithm* spectralContrast = factory.create("SpectralContrast",
         "sampleRate", sampleRate,
@@ -53,18 +54,23 @@ std::vector<Real> extractSpectralContrastFeatures(
     spectralContrast->output("spectralValley").set(scValleys);
 
     std::vector<std::vector<Real>> allSCFeatures;
-    while (true) {
-        frameCutter->compute();
-        if (frame.empty()) break;
+    const std::vector<size_t> starts = StftEngine::frameStarts(audioBuffer.size(), frameSize, hopSize, mask);
+    for (size_t blockStart = 0; blockStart < starts.size(); blockStart += StftEngine::BLOCK_FRAMES) {
+        const int count = static_cast<int>(std::min<size_t>(StftEngine::BLOCK_FRAMES, starts.size() - blockStart));
+        for (int f = 0; f < count; ++f) {
+            stft.loadFrame(f, audioBuffer, starts[blockStart + f], window.data());
+        }
+        stft.execute(count);
+
+        for (int f = 0; f < count; ++f) {
+            stft.magnitudeSpectrum(f, spectrumFrame.data());
+            spectralContrast->compute();
 
-        windowing->compute();
-        spectrum->compute();
-        spectralContrast->compute();
-        
-        std::vector<Real> frameFeatures;
-        frameFeatures.insert(frameFeatures.end(), scPeaks.begin(), scPeaks.end());
-        frameFeatures.insert(frameFeatures.end(), scValleys.begin(), scValleys.end());
-        allSCFeatures.push_back(frameFeatures);
+            std::vector<Real> frameFeatures;
+            frameFeatures.insert(frameFeatures.end(), scPeaks.begin(), scPeaks.end());
+            frameFeatures.insert(frameFeatures.end(), scValleys.begin(), scValleys.end());
+            allSCFeatures.push_back(frameFeatures);
+        }
     }
 
     std::vector<Real> meanFeatures, stdFeatures, finalVec;
@@ -74,9 +80,6 @@ std::vector<Real> extractSpectralContrastFeatures(
         finalVec.insert(finalVec.end(), stdFeatures.begin(), stdFeatures.end());
     }
 
-    delete frameCutter;
-    delete windowing;
-    delete spectrum;
     delete spectralContrast;
 
     if (appendToFeatureVector) {
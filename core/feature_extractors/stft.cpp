@@ -0,0 +1,189 @@
+#include "stft.h"
+#include "../../utils/fftw_planner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Block plan plus a one-frame plan for the tail of a clip. Rows are padded to 64 bytes
+// so every row of a thread's buffer has the alignment the plans were created with.
+struct StftEngine::Plans {
+    int timeStride;
+    int freqStride;
+    fftwf_plan block;
+    fftwf_plan single;
+
+    explicit Plans(int frameSize)
+        : timeStride((frameSize + 15) / 16 * 16), freqStride((frameSize / 2 + 1 + 7) / 8 * 8) {
+        auto lock = harmony::FftwPlanner::lock();
+        harmony::FftwPlanner::importWisdom();
+
+        float* time = fftwf_alloc_real(static_cast<size_t>(timeStride) * BLOCK_FRAMES);
+        fftwf_complex* freq = fftwf_alloc_complex(static_cast<size_t>(freqStride) * BLOCK_FRAMES);
+        const int n[] = {frameSize};
+        block = fftwf_plan_many_dft_r2c(1, n, BLOCK_FRAMES, time, nullptr, 1, timeStride,
+                                        freq, nullptr, 1, freqStride, FFTW_MEASURE);
+        single = fftwf_plan_dft_r2c_1d(frameSize, time, freq, FFTW_MEASURE);
+        fftwf_free(time);
+        fftwf_free(freq);
+
+        harmony::FftwPlanner::exportWisdom();
+    }
+
+    Plans(const Plans&) = delete;
+    Plans& operator=(const Plans&) = delete;
+};
+
+namespace {
+    // FrameCutter adds noise at -100 dB to all-zero frames instead of passing them on
+    const float SILENT_FRAME_POWER = 1e-10f;
+    const float SILENT_FRAME_NOISE = 1e-5f;
+
+    // Plans live for the whole process; they are never destroyed, so no static
+    // destructor can run after the planner state is gone
+    const StftEngine::Plans& plansFor(int frameSize) {
+        static std::mutex mutex;
+        static auto& cache = *new std::map<int, std::unique_ptr<StftEngine::Plans>>();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& plans = cache[frameSize];
+        if (!plans) {
+            plans = std::make_unique<StftEngine::Plans>(frameSize);
+        }
+        return *plans;
+    }
+
+    // Per-thread block buffers for one frame size
+    struct Buffers {
+        float* time;
+        fftwf_complex* freq;
+
+        explicit Buffers(const StftEngine::Plans& plans) {
+            time = fftwf_alloc_real(static_cast<size_t>(plans.timeStride) * StftEngine::BLOCK_FRAMES);
+            freq = fftwf_alloc_complex(static_cast<size_t>(plans.freqStride) * StftEngine::BLOCK_FRAMES);
+        }
+
+        ~Buffers() {
+            fftwf_free(time);
+            fftwf_free(freq);
+        }
+
+        Buffers(const Buffers&) = delete;
+        Buffers& operator=(const Buffers&) = delete;
+    };
+
+    Buffers& buffersFor(int frameSize, const StftEngine::Plans& plans) {
+        thread_local std::map<int, std::unique_ptr<Buffers>> buffers;
+        auto& entry = buffers[frameSize];
+        if (!entry) {
+            entry = std::make_unique<Buffers>(plans);
+        }
+        return *entry;
+    }
+}
+
+StftEngine::StftEngine(int frameSize) : frameSize(frameSize) {
+    if (frameSize < 2 || frameSize % 2 != 0) {
+        throw std::invalid_argument("StftEngine frame size must be even");
+    }
+    plans = &plansFor(frameSize);
+}
+
+std::vector<size_t> StftEngine::frameStarts(size_t length, int frameSize, int hopSize, const ActivityMask* mask) {
+    std::vector<size_t> starts;
+    if (length == 0 || hopSize <= 0) return starts;
+    // The last frame is the first one reaching the end of the signal, zero-padded past it
+    for (size_t start = 0; start < length; start += hopSize) {
+        if (!mask || mask->isActive(start, frameSize)) starts.push_back(start);
+        if (start + frameSize >= length) break;
+    }
+    return starts;
+}
+
+std::vector<float> StftEngine::hannWindow(int size) {
+    std::vector<float> window(size);
+    for (int i = 0; i < size; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / (size - 1.0)));
+    }
+    return window;
+}
+
+float* StftEngine::frame(int index) const {
+    return buffersFor(frameSize, *plans).time + static_cast<size_t>(index) * plans->timeStride;
+}
+
+void StftEngine::loadFrame(int index, std::span<const float> audio, size_t start, const float* window) const {
+    float* row = frame(index);
+    const size_t available = start < audio.size() ? std::min<size_t>(frameSize, audio.size() - start) : 0;
+    std::copy(audio.begin() + start, audio.begin() + start + available, row);
+    std::fill(row + available, row + frameSize, 0.0f);
+
+    double energy = 0.0;
+    for (int i = 0; i < frameSize; ++i) energy += static_cast<double>(row[i]) * row[i];
+    if (energy / frameSize < SILENT_FRAME_POWER) {
+        thread_local std::minstd_rand noise;
+        std::uniform_real_distribution<float> noiseSample(-SILENT_FRAME_NOISE, SILENT_FRAME_NOISE);
+        for (int i = 0; i < frameSize; ++i) row[i] += noiseSample(noise);
+    }
+
+    if (window) {
+        for (int i = 0; i < frameSize; ++i) row[i] *= window[i];
+    }
+}
+
+void StftEngine::execute(int count) const {
+    Buffers& buffers = buffersFor(frameSize, *plans);
+    if (count == BLOCK_FRAMES) {
+        fftwf_execute_dft_r2c(plans->block, buffers.time, buffers.freq);
+        return;
+    }
+    for (int f = 0; f < count; ++f) {
+        fftwf_execute_dft_r2c(plans->single, buffers.time + static_cast<size_t>(f) * plans->timeStride,
+                              buffers.freq + static_cast<size_t>(f) * plans->freqStride);
+    }
+}
+
+const float* StftEngine::spectrum(int index) const {
+    return reinterpret_cast<const float*>(buffersFor(frameSize, *plans).freq + static_cast<size_t>(index) * plans->freqStride);
+}
+
+void StftEngine::powerSpectrum(int index, float* out) const {
+    const float* spectrum = this->spectrum(index);
+    const int bins = getBins();
+    int k = 0;
+#if defined(__SSE2__)
+    // Two interleaved (re, im) pairs per load; shuffle the squares into re^2 + im^2
+    for (; k + 4 <= bins; k += 4) {
+        const __m128 a = _mm_loadu_ps(spectrum + 2 * k);
+        const __m128 b = _mm_loadu_ps(spectrum + 2 * k + 4);
+        const __m128 a2 = _mm_mul_ps(a, a);
+        const __m128 b2 = _mm_mul_ps(b, b);
+        const __m128 re = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + k, _mm_add_ps(re, im));
+    }
+#endif
+    for (; k < bins; ++k) {
+        out[k] = spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+    }
+}
+
+void StftEngine::magnitudeSpectrum(int index, float* out) const {
+    powerSpectrum(index, out);
+    const int bins = getBins();
+    int k = 0;
+#if defined(__SSE2__)
+    for (; k + 4 <= bins; k += 4) {
+        _mm_storeu_ps(out + k, _mm_sqrt_ps(_mm_loadu_ps(out + k)));
+    }
+#endif
+    for (; k < bins; ++k) {
+        out[k] = std::sqrt(out[k]);
+    }
+}
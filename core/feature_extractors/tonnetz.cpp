@@ -1,81 +1,103 @@
 #include "tonnetz.h"
+#include "chroma.h"
 #include "feature_utils.h"
 
 using namespace essentia;
 using namespace standard;
 
+namespace {
+    // TonalExtractor's framing, with chroma taken from the sparse constant-Q kernel
+    const int TONNETZ_FRAME_SIZE = 4096;
+    const int TONNETZ_HOP_SIZE = 2048;
+    // C2, so pitch class 0 is C as the tonnetz basis expects
+    const float TONNETZ_MIN_FREQUENCY = 65.406f;
+    // Three bins per semitone absorb tuning offsets before folding to 12 pitch classes
+    const int TONNETZ_BINS_PER_OCTAVE = 36;
+    const float TONNETZ_KERNEL_THRESHOLD = 0.01f;
+    const int TONNETZ_DIMENSIONS = 6;
+
+    // Harte, Sandler & Gasser (2006): pitch class l maps to the circles of fifths,
+    // minor thirds and major thirds, with radii 1, 1 and 0.5
+    std::array<std::array<float, 12>, TONNETZ_DIMENSIONS> tonnetzBasis() {
+        const double angles[3] = {7.0 * M_PI / 6.0, 3.0 * M_PI / 2.0, 2.0 * M_PI / 3.0};
+        const double radii[3] = {1.0, 1.0, 0.5};
+        std::array<std::array<float, 12>, TONNETZ_DIMENSIONS> basis{};
+        for (int circle = 0; circle < 3; ++circle) {
+            for (int l = 0; l < 12; ++l) {
+                basis[2 * circle][l] = static_cast<float>(radii[circle] * std::sin(l * angles[circle]));
+                basis[2 * circle + 1][l] = static_cast<float>(radii[circle] * std::cos(l * angles[circle]));
+            }
+        }
+        return basis;
+    }
+}
+
 std::vector<Real> extractTonnetzFeatures(
     const std::string& filename,
     int sampleRate,
     AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity
 ) {
-    std::vector<Real> audioBuffer;
+    (void)factory;
+    std::vector<Real> loaded;
+    std::span<const Real> audioBuffer = inputAudio;
     if(inputAudio.empty()) {
         // Load audio file
-        Algorithm* loader = createAudioLoader(filename, sampleRate, audioBuffer);
-        if (audioBuffer.empty()) {
+        Algorithm* loader = createAudioLoader(filename, sampleRate, loaded);
+        if (loaded.empty()) {
             std::cerr << "Error loading audio file: " << filename << std::endl;
             return {};
         }
         delete loader;
-    } else {
-        audioBuffer = inputAudio;
+        audioBuffer = loaded;
     }
 
-    Algorithm* tonal = factory.create("TonalExtractor");
-    
-    std::vector<std::vector<Real>> hpcpFrames;
-    std::string key_key, key_scale;
-    Real key_strength;
-    Real chords_changes_rate;
-    std::vector<Real> chords_histogram;
-    std::string chords_key;
-    Real chords_number_rate;
-    std::vector<std::string> chords_progression;
-    std::string chords_scale;
-    std::vector<Real> chords_strength;
-    std::vector<std::vector<Real>> hpcp_highres;  
+    const ActivityMask* mask = prepareActiveRegion(audioBuffer, activity);
 
-    //most of them are useless outputs, but we need to set them to avoid errors
-    tonal->input("signal").set(audioBuffer);
-    tonal->output("hpcp").set(hpcpFrames);
-    tonal->output("key_key").set(key_key);
-    tonal->output("key_scale").set(key_scale);
-    tonal->output("key_strength").set(key_strength);
-    tonal->output("chords_changes_rate").set(chords_changes_rate);
-    tonal->output("chords_histogram").set(chords_histogram);
-    tonal->output("chords_key").set(chords_key);
-    tonal->output("chords_number_rate").set(chords_number_rate);
-    tonal->output("chords_progression").set(chords_progression);
-    tonal->output("chords_scale").set(chords_scale);
-    tonal->output("chords_strength").set(chords_strength);
-    tonal->output("hpcp_highres").set(hpcp_highres);
+    ChromaEngine engine(sampleRate, TONNETZ_FRAME_SIZE, TONNETZ_MIN_FREQUENCY, TONNETZ_BINS_PER_OCTAVE,
+                        TONNETZ_KERNEL_THRESHOLD, "hann");
+    std::vector<std::vector<Real>> chroma;
+    engine.compute(audioBuffer, TONNETZ_HOP_SIZE, mask, chroma);
 
-    tonal->compute();
+    static const auto basis = tonnetzBasis();
+    const int binsPerSemitone = TONNETZ_BINS_PER_OCTAVE / 12;
+    std::vector<std::vector<Real>> allTonnetz;
+    allTonnetz.reserve(chroma.size());
+    for (const auto& frame : chroma) {
+        // Fold each semitone's bins (centred on bin binsPerSemitone * l) into pitch class l
+        std::array<float, 12> pitchClass{};
+        float total = 0.0f;
+        for (int b = 0; b < TONNETZ_BINS_PER_OCTAVE; ++b) {
+            const int l = ((b + binsPerSemitone / 2) / binsPerSemitone) % 12;
+            pitchClass[l] += frame[b];
+            total += frame[b];
+        }
 
-    std::vector<Real> features;
-    
-    if (!hpcpFrames.empty()) {
-        std::vector<Real> hpcpAvg(12, 0.0);
-        for (const auto& frame : hpcpFrames) {
-            for (int i = 0; i < 12; i++) {
-                hpcpAvg[i] += frame[i];
+        // L1-normalised chroma projected onto the six tonnetz axes
+        std::vector<Real> centroid(TONNETZ_DIMENSIONS, 0.0f);
+        if (total > 0.0f) {
+            for (int d = 0; d < TONNETZ_DIMENSIONS; ++d) {
+                float sum = 0.0f;
+                for (int l = 0; l < 12; ++l) sum += basis[d][l] * pitchClass[l];
+                centroid[d] = sum / total;
             }
         }
-        for (auto& val : hpcpAvg) val /= hpcpFrames.size();
-        features.insert(features.end(), hpcpAvg.begin(), hpcpAvg.end());
+        allTonnetz.push_back(std::move(centroid));
     }
-    
-    features.push_back(key_strength);
 
-    delete tonal;
+    std::vector<Real> meanTonnetz, stdTonnetz, features;
+    if (!allTonnetz.empty()) {
+        computeStats(allTonnetz, meanTonnetz, stdTonnetz);
+        features.insert(features.end(), meanTonnetz.begin(), meanTonnetz.end());
+        features.insert(features.end(), stdTonnetz.begin(), stdTonnetz.end());
+    }
 
     if (appendToFeatureVector) {
         featureVector.insert(featureVector.end(), features.begin(), features.end());
     }
     return features;
 
-}
\ No newline at end of file
+}
@@ -4,8 +4,14 @@
 #include <unistd.h>
 #include <omp.h>
 #include "audio_preprocessor.hpp"
+#include "../audio/pcm_archive.hpp"
+#include "polyphase_resampler.hpp"
+#include "spectral_denoiser.hpp"
+#include "voice_activity.hpp"
+#include "signal_level.hpp"
 #include <mutex>
 #include <atomic>
+#include <sstream>
 
 using namespace essentia;
 using namespace standard;
@@ -25,75 +31,139 @@ AudioPreprocessor::~AudioPreprocessor()
     essentia::shutdown();
 }
 
-bool AudioPreprocessor::processFile(const std::string &inputPath, const std::string &outputPath, float &duration, AlgorithmFactory &factory, std::vector<essentia::Real> &result, bool saveFile)
+std::string AudioPreprocessor::settingsSignature() const
 {
-    if (!fs::exists(inputPath))
+    std::ostringstream oss;
+    oss << "sr=16000:loader+polyphase"
+        << ",silence=" << silenceRemovalEnabled << ":vad:" << silenceThreshold << ":" << minSilenceMs
+        << ",trim=" << trimEnabled << ":" << targetDuration
+        << ",normalize=" << normalizeEnabled << ":dc:" << targetRMS
+        << ",denoise=" << noiseReductionEnabled << ":wiener:valid:" << noiseThreshold;
+    return oss.str();
+}
+
+const DspChain &AudioPreprocessor::stages()
+{
+    std::lock_guard<std::mutex> lock(chainMutex);
+    if (chain)
     {
-        std::cerr << "Input file does not exist: " << inputPath << '\n';
-        return false;
+        return *chain;
     }
 
-    std::unique_ptr<Algorithm> resampler;
+    // Stages read their parameters when they run, so only the enable flags shape the chain
+    const int targetSampleRate = 16000;
+    chain = std::make_unique<DspChain>();
 
-    try
+    chain->add("resample", [targetSampleRate](StageContext &ctx)
     {
-        int sampleRate = 0;
-        std::vector<Real> audioBuffer = AudioUtil::readAudioFile(inputPath, duration, sampleRate);
-
-        if (audioBuffer.empty())
+        if (ctx.sampleRate == targetSampleRate)
         {
-            return false;
+            return true;
         }
 
-        // Resample to 16kHz if necessary
-        const int targetSampleRate = 16000;
-        if (sampleRate != targetSampleRate)
+        if (PolyphaseResampler::supports(ctx.sampleRate, targetSampleRate))
         {
-
-            Algorithm *ptr = factory.create("Resample",
-                                                    "inputSampleRate", sampleRate,
-                                                    "outputSampleRate", targetSampleRate,
-                                                    "quality", 1); // 1 is high quality
-            resampler = std::unique_ptr<Algorithm>(ptr);
-
-            std::vector<Real> resampledBuffer;
-            resampler->input("signal").set(audioBuffer);
-            resampler->output("signal").set(resampledBuffer);
+            // Filter banks are cached per rate pair and shared across files and threads
+            PolyphaseResampler::forRates(ctx.sampleRate, targetSampleRate).process(*ctx.signal, *ctx.scratch);
+        }
+        else
+        {
+            std::unique_ptr<Algorithm> resampler(AlgorithmFactory::instance().create("Resample",
+                                                                                   "inputSampleRate", ctx.sampleRate,
+                                                                                   "outputSampleRate", targetSampleRate,
+                                                                                   "quality", 1)); // 1 is high quality
+            resampler->input("signal").set(*ctx.signal);
+            resampler->output("signal").set(*ctx.scratch);
             resampler->compute();
-
-            // Replace original buffer with resampled buffer
-            audioBuffer = resampledBuffer;
-            sampleRate = targetSampleRate;
-
-            resampler.reset();
         }
+        ctx.swap();
+        ctx.sampleRate = targetSampleRate;
+        return true;
+    });
 
-        // Apply processing steps according to enabled flags
-        if (silenceRemovalEnabled)
+    // Always present: the mask may be requested even when silence is kept
+    chain->add("vad", [this](StageContext &ctx)
+    {
+        if (silenceRemovalEnabled || ctx.wantActivity)
         {
-            removeSilence(audioBuffer, sampleRate);
+            removeSilence(*ctx.signal, ctx.sampleRate, *ctx.activity);
         }
+        // Samples of real audio; trimAudio may zero-pad beyond this point
+        ctx.validSamples = ctx.signal->size();
+        return true;
+    });
 
-        if (trimEnabled)
+    if (trimEnabled)
+    {
+        chain->add("trim", [this](StageContext &ctx)
         {
-            trimAudio(audioBuffer, sampleRate);
-            if (audioBuffer.empty())
-            {
-                return false;
-            }
-        }
+            trimAudio(*ctx.signal, ctx.sampleRate, *ctx.activity);
+            ctx.validSamples = std::min(ctx.validSamples, ctx.signal->size());
+            return !ctx.signal->empty();
+        });
+    }
 
-        if (noiseReductionEnabled)
+    if (noiseReductionEnabled)
+    {
+        chain->add("denoise", [this](StageContext &ctx)
         {
-            reduceNoise(audioBuffer);
-        }
+            reduceNoise(*ctx.signal, ctx.validSamples);
+            return true;
+        });
+    }
+
+    if (normalizeEnabled)
+    {
+        chain->add("normalize", [this](StageContext &ctx)
+        {
+            normalizeVolume(*ctx.signal, ctx.validSamples);
+            return true;
+        });
+    }
+
+    return *chain;
+}
+
+std::string AudioPreprocessor::describeChain()
+{
+    return stages().describe();
+}
+
+bool AudioPreprocessor::processFile(const std::string &inputPath, const std::string &outputPath, float &duration, AlgorithmFactory &factory, std::vector<essentia::Real> &result, bool saveFile, ActivityMask *activity)
+{
+    if (!fs::exists(inputPath))
+    {
+        std::cerr << "Input file does not exist: " << inputPath << '\n';
+        return false;
+    }
+
+    try
+    {
+        const DspChain &pipeline = stages();
+
+        // Ping-pong buffers owned by this thread: once they have grown to the longest clip,
+        // decoding and every stage run without allocating
+        StageArena &arena = StageArena::local();
+        arena.activity.frameSize = 0;
+        arena.activity.active.clear();
+        arena.activity.validSamples = 0;
+
+        StageContext ctx;
+        ctx.signal = &arena.front;
+        ctx.scratch = &arena.back;
+        ctx.activity = &arena.activity;
+        ctx.wantActivity = activity != nullptr;
 
-        if (normalizeEnabled)
+        // Compressed input is decoded straight to 16 kHz; native WAVs come back at their own rate
+        AudioUtil::readAudioInto(inputPath, *ctx.signal, duration, ctx.sampleRate, 16000);
+
+        if (ctx.signal->empty() || !pipeline.run(ctx))
         {
-            normalizeVolume(audioBuffer);
+            return false;
         }
 
-        duration = static_cast<float>(audioBuffer.size()) / static_cast<float>(sampleRate);
+        const std::vector<Real> &audioBuffer = *ctx.signal;
+        duration = static_cast<float>(audioBuffer.size()) / static_cast<float>(ctx.sampleRate);
 
         if (saveFile)
         {
@@ -103,11 +173,20 @@ bool AudioPreprocessor::processFile(const std::string &inputPath, const std::str
             {
                 fs::create_directories(outputDir);
             }
-            return writeAudioFile(audioBuffer, sampleRate, outputPath, factory);
+            return writeAudioFile(audioBuffer, ctx.sampleRate, outputPath, factory);
         }
         else
         {
-            result = audioBuffer;
+            // assign() keeps the caller's capacity, so a result vector reused across files
+            // is not reallocated either
+            result.assign(audioBuffer.begin(), audioBuffer.end());
+        }
+
+        if (activity)
+        {
+            activity->frameSize = arena.activity.frameSize;
+            activity->validSamples = arena.activity.validSamples;
+            activity->active.assign(arena.activity.active.begin(), arena.activity.active.end());
         }
 
         // Write the processed audio
@@ -115,7 +194,6 @@ bool AudioPreprocessor::processFile(const std::string &inputPath, const std::str
     }
     catch (const std::exception &e)
     {
-        resampler.reset();
         std::cerr << "Error processing file " << inputPath << ": " << e.what() << '\n';
         return false;
     }
@@ -218,6 +296,14 @@ int AudioPreprocessor::processBatch(
 
     AlgorithmFactory &factory = AlgorithmFactory::instance();
 
+    if (showProgress)
+    {
+        std::cout << "Preprocessing chain: " << describeChain() << '\n';
+    }
+
+    // Reused for every clip so archived output does not reallocate per file
+    std::vector<essentia::Real> result;
+
     for (size_t i = 0; i < linesToProcessVector.size(); i++)
     {
         const std::string &currentLine = linesToProcessVector[i];
@@ -240,9 +326,7 @@ int AudioPreprocessor::processBatch(
         fflush(stderr);
         dup2(open("/dev/null", O_WRONLY), fileno(stderr));
 
-        std::vector<essentia::Real> result;
-
-        bool success = processFile(dataPath + "/" + tokens[1], outputPath.string(), duration, factory, result);
+        bool success = processFile(dataPath + "/" + tokens[1], outputPath.string(), duration, factory, result, pcmArchive == nullptr);
 
         // Restore stderr
         if (saved_stderr != -1)
@@ -252,6 +336,20 @@ int AudioPreprocessor::processBatch(
             close(saved_stderr);
         }
 
+        if (success && pcmArchive)
+        {
+            // Archived clips keep the .wav name so metadata is identical in both modes
+            try
+            {
+                pcmArchive->add(outputPath.filename().string(), result);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << e.what() << '\n';
+                success = false;
+            }
+        }
+
         if (success)
         {
             fs::path relativePath = fs::path(outputPath).filename();
@@ -284,7 +382,7 @@ int AudioPreprocessor::processBatch(
 
 // Individual processing functions
 
-void AudioPreprocessor::trimAudio(std::vector<essentia::Real> &audioBuffer, int &sampleRate)
+void AudioPreprocessor::trimAudio(std::vector<essentia::Real> &audioBuffer, int &sampleRate, ActivityMask &activity)
 {
     // Calculate number of samples to keep
     int targetSamples = static_cast<int>(targetDuration * sampleRate);
@@ -298,17 +396,23 @@ void AudioPreprocessor::trimAudio(std::vector<essentia::Real> &audioBuffer, int
     {
         audioBuffer.resize(targetSamples, 0.0f);
     }
+
+    // Padding is never speech; the mask keeps the original length as its valid range
+    activity.fitTo(audioBuffer.size());
 }
 
-void AudioPreprocessor::normalizeVolume(std::vector<essentia::Real> &audioBuffer)
+void AudioPreprocessor::normalizeVolume(std::vector<essentia::Real> &audioBuffer, size_t validSamples)
 {
-    if (audioBuffer.empty())
+    validSamples = std::min(validSamples, audioBuffer.size());
+    if (validSamples == 0)
     {
         return;
     }
 
-    // Calculate current RMS
-    float currentRMS = calculateRMS(audioBuffer);
+    // Statistics over real audio only, so trimAudio's padding neither dilutes the RMS
+    // nor picks up the DC correction (it must stay exactly zero for the extractors)
+    const SignalStats stats = SignalLevel::measure(audioBuffer.data(), validSamples);
+    const double currentRMS = stats.acRms();
 
     // If RMS is close to zero, avoid division by zero
     if (currentRMS < 1e-6)
@@ -316,105 +420,27 @@ void AudioPreprocessor::normalizeVolume(std::vector<essentia::Real> &audioBuffer
         return;
     }
 
-    // Calculate scaling factor
-    float scaleFactor = targetRMS / currentRMS;
-
-    // Apply gain
-    for (auto &sample : audioBuffer)
-    {
-        sample *= scaleFactor;
-
-        // Apply soft clipping to avoid distortion if needed
-        if (sample > 0.95f)
-        {
-            sample = 0.95f;
-        }
-        else if (sample < -0.95f)
-        {
-            sample = -0.95f;
-        }
-    }
+    // DC removal, gain and clipping to +-0.95 in one pass
+    const float scaleFactor = static_cast<float>(targetRMS / currentRMS);
+    SignalLevel::applyGain(audioBuffer.data(), validSamples, scaleFactor, static_cast<float>(stats.mean()), 0.95f);
 }
 
-void AudioPreprocessor::reduceNoise(std::vector<essentia::Real> &audioBuffer)
+void AudioPreprocessor::reduceNoise(std::vector<essentia::Real> &audioBuffer, size_t validSamples)
 {
-    if (audioBuffer.empty())
+    validSamples = std::min(validSamples, audioBuffer.size());
+    if (validSamples == 0)
     {
         return;
     }
 
     try
     {
-        // Create spectral gate algorithm using Essentia
-        AlgorithmFactory &factory = AlgorithmFactory::instance();
-
-        // Convert to spectrum
-        Algorithm *fftwfft = factory.create("FFT");
-        Algorithm *window = factory.create("Windowing", "type", "hann");
-        Algorithm *ifft = factory.create("IFFT");
-
-        const int frameSize = 2048;
-        const int hopSize = 1024;
-
-        // Process frame by frame
-        for (int i = 0; i < int(audioBuffer.size()); i += hopSize)
-        {
-            // Extract frame
-            std::vector<Real> frame;
-            for (int j = 0; j < frameSize; ++j)
-            {
-                if (i + j < int(audioBuffer.size()))
-                {
-                    frame.push_back(audioBuffer[i + j]);
-                }
-                else
-                {
-                    frame.push_back(0.0f); // Zero padding
-                }
-            }
-
-            // Apply window
-            std::vector<Real> windowedFrame;
-            window->input("frame").set(frame);
-            window->output("frame").set(windowedFrame);
-            window->compute();
-
-            // Calculate FFT
-            std::vector<std::complex<Real>> spectrum;
-            fftwfft->input("frame").set(windowedFrame);
-            fftwfft->output("fft").set(spectrum);
-            fftwfft->compute();
-
-            // Apply spectral gating (simple noise reduction)
-            for (auto &bin : spectrum)
-            {
-                Real magnitude = std::abs(bin);
-                if (magnitude < noiseThreshold)
-                {
-                    bin = std::complex<Real>(0.0f, 0.0f);
-                }
-            }
-
-            // Inverse FFT
-            std::vector<Real> processedFrame;
-            ifft->input("fft").set(spectrum);
-            ifft->output("frame").set(processedFrame);
-            ifft->compute();
-
-            // Overlap-add to output buffer
-            for (int j = 0; j < frameSize; ++j)
-            {
-                if (i + j < int(audioBuffer.size()))
-                {
-                    audioBuffer[i + j] = processedFrame[j];
-                }
-            }
-        }
-
-        // Clean up algorithms
-        delete fftwfft;
-        delete window;
-        delete ifft;
+        // 32 ms frames at 16 kHz; the window and FFT plans are cached per thread, so
+        // constructing the denoiser per file allocates nothing
+        SpectralDenoiser denoiser(512);
+        denoiser.setNoiseThreshold(noiseThreshold);
+        // Padding would pull the noise profile towards zero and pick up overlap-add tails
+        denoiser.process(audioBuffer, validSamples);
     }
     catch (const std::exception &e)
     {
@@ -422,107 +448,30 @@ void AudioPreprocessor::reduceNoise(std::vector<essentia::Real> &audioBuffer)
     }
 }
 
-void AudioPreprocessor::removeSilence(std::vector<essentia::Real> &audioBuffer, int &sampleRate)
+void AudioPreprocessor::removeSilence(std::vector<essentia::Real> &audioBuffer, int &sampleRate, ActivityMask &activity)
 {
     if (audioBuffer.empty())
     {
         return;
     }
 
-    // Calculate number of samples for minimum silence duration
-    int minSilenceSamples = static_cast<int>(minSilenceMs * sampleRate / 1000);
+    // Frame-level energy/ZCR decisions; pauses of at least minSilenceMs are cut out in place
+    VoiceActivityDetector vad(sampleRate);
+    vad.setEnergyThreshold(silenceThreshold);
+    vad.setMinSilenceMs(minSilenceMs);
+    vad.detect(audioBuffer, activity);
 
-    // Find silent segments
-    std::vector<std::pair<int, int>> silentSegments;
-    int silenceStart = 0;
-    bool inSilence = false;
-
-    for (int i = 0; i < int(audioBuffer.size()); ++i)
+    if (silenceRemovalEnabled)
     {
-        float amplitude = std::abs(audioBuffer[i]);
-
-        if (amplitude < silenceThreshold)
-        {
-            // Entering silence
-            if (!inSilence)
-            {
-                silenceStart = i;
-                inSilence = true;
-            }
-        }
-        else
-        {
-            // Exiting silence
-            if (inSilence)
-            {
-                int silenceEnd = i;
-                int silenceLength = silenceEnd - silenceStart;
-
-                // If silence is long enough, mark it for removal
-                if (silenceLength >= minSilenceSamples)
-                {
-                    silentSegments.push_back(std::make_pair(silenceStart, silenceEnd));
-                }
-
-                inSilence = false;
-            }
-        }
-    }
-
-    // If we end with silence, add that segment too
-    if (inSilence)
-    {
-        int silenceLength = int(audioBuffer.size()) - silenceStart;
-        if (silenceLength >= minSilenceSamples)
-        {
-            silentSegments.push_back(std::make_pair(silenceStart, int(audioBuffer.size())));
-        }
+        vad.compact(audioBuffer, activity);
     }
-
-    // If no silent segments found, return
-    if (silentSegments.empty())
-    {
-        return;
-    }
-
-    // Create new buffer without the silent segments
-    std::vector<Real> processedBuffer;
-    int lastEnd = 0;
-
-    for (const auto &segment : silentSegments)
-    {
-        // Add audio before this silent segment
-        processedBuffer.insert(
-            processedBuffer.end(),
-            audioBuffer.begin() + lastEnd,
-            audioBuffer.begin() + segment.first);
-
-        lastEnd = segment.second;
-    }
-
-    // Add the final portion after the last silent segment
-    if (lastEnd < int(audioBuffer.size()))
-    {
-        processedBuffer.insert(
-            processedBuffer.end(),
-            audioBuffer.begin() + lastEnd,
-            audioBuffer.end());
-    }
-
-    // Replace original buffer with processed buffer
-    audioBuffer = processedBuffer;
 }
 
 // Utility methods
 
 float AudioPreprocessor::calculateRMS(const std::vector<essentia::Real> &buffer)
 {
-    float sumSquared = 0.0f;
-    for (const auto &sample : buffer)
-    {
-        sumSquared += sample * sample;
-    }
-    return std::sqrt(sumSquared / buffer.size());
+    return static_cast<float>(SignalLevel::measure(buffer.data(), buffer.size()).rms());
 }
 
 bool AudioPreprocessor::writeAudioFile(const std::vector<essentia::Real> &buffer, int &sampleRate, const std::string &filePath, AlgorithmFactory &factory)
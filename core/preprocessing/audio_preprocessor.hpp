@@ -11,14 +11,20 @@
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <memory>
+#include <mutex>
+#include "activity_mask.h"
+#include "dsp_chain.hpp"
+
+class PcmArchiveWriter;
 
 class AudioPreprocessor {
 public:
     AudioPreprocessor(float targetDuration = 5.0f);
     ~AudioPreprocessor();
     
-    // Process a single file
-    bool processFile(const std::string& inputPath, const std::string& outputPath, float& duration, essentia::standard::AlgorithmFactory& factory, std::vector<essentia::Real>& result, bool saveFile = true);
+    // Process a single file; when activity is given it receives the speech mask of the processed clip
+    bool processFile(const std::string& inputPath, const std::string& outputPath, float& duration, essentia::standard::AlgorithmFactory& factory, std::vector<essentia::Real>& result, bool saveFile = true, ActivityMask* activity = nullptr);
     
     // Process a batch of files
     int processBatch(
@@ -29,17 +35,29 @@ public:
         int startLine = 0,
         int endLine = -1);
     
-    // Configuration setters
-    void enableTrimming(bool enable = true) { trimEnabled = enable; }
-    void enableNormalization(bool enable = true) { normalizeEnabled = enable; }
-    void enableNoiseReduction(bool enable = true) { noiseReductionEnabled = enable; }
-    void enableSilenceRemoval(bool enable = true) { silenceRemovalEnabled = enable; }
+    // Configuration setters; toggling a stage rebuilds the chain on the next file
+    void enableTrimming(bool enable = true) { trimEnabled = enable; chain.reset(); }
+    void enableNormalization(bool enable = true) { normalizeEnabled = enable; chain.reset(); }
+    void enableNoiseReduction(bool enable = true) { noiseReductionEnabled = enable; chain.reset(); }
+    void enableSilenceRemoval(bool enable = true) { silenceRemovalEnabled = enable; chain.reset(); }
     
     void setTargetDuration(float seconds) { targetDuration = seconds; }
     void setTargetRMS(float rms) { targetRMS = rms; }
     void setNoiseThreshold(float threshold) { noiseThreshold = threshold; }
     void setSilenceThreshold(float threshold) { silenceThreshold = threshold; }
     void setMinSilenceMs(int ms) { minSilenceMs = ms; }
+
+    // Store processed clips in a packed PCM archive instead of writing one WAV per clip
+    void setPcmArchive(PcmArchiveWriter* archive) { pcmArchive = archive; }
+
+    // Describes every setting that affects the processed audio (used as a cache key)
+    std::string settingsSignature() const;
+
+    // Writes a processed clip as a WAV file, creating its directory if needed
+    bool writeAudioFile(const std::vector<essentia::Real>& buffer, int& sampleRate, const std::string& filePath, essentia::standard::AlgorithmFactory& factory);
+
+    // Stage names of the current chain, e.g. "resample>vad>trim>denoise>normalize"
+    std::string describeChain();
     
 private:
     // Processing parameters
@@ -48,20 +66,25 @@ private:
     float noiseThreshold = 0.01f;
     float silenceThreshold = 0.01f;
     int minSilenceMs = 500;
+    PcmArchiveWriter* pcmArchive = nullptr;
     
     // Enabled flags
     bool trimEnabled = true;
     bool normalizeEnabled = true;
     bool noiseReductionEnabled = true;
     bool silenceRemovalEnabled = true;
+
+    // Stages built from the enabled flags, created lazily and shared by all threads
+    std::unique_ptr<DspChain> chain;
+    std::mutex chainMutex;
+    const DspChain& stages();
     
     // Individual processing functions
-    void trimAudio(std::vector<essentia::Real>& audioBuffer, int& sampleRate);
-    void normalizeVolume(std::vector<essentia::Real>& audioBuffer);
-    void reduceNoise(std::vector<essentia::Real>& audioBuffer);
-    void removeSilence(std::vector<essentia::Real>& audioBuffer, int& sampleRate);
+    void trimAudio(std::vector<essentia::Real>& audioBuffer, int& sampleRate, ActivityMask& activity);
+    void normalizeVolume(std::vector<essentia::Real>& audioBuffer, size_t validSamples);
+    void reduceNoise(std::vector<essentia::Real>& audioBuffer, size_t validSamples);
+    void removeSilence(std::vector<essentia::Real>& audioBuffer, int& sampleRate, ActivityMask& activity);
     
     // Utility methods
     float calculateRMS(const std::vector<essentia::Real>& buffer);
-    bool writeAudioFile(const std::vector<essentia::Real>& buffer, int& sampleRate, const std::string& filePath, essentia::standard::AlgorithmFactory& factory);
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "dsp_chain.hpp"
+
+StageArena &StageArena::local()
+{
+    thread_local StageArena arena;
+    return arena;
+}
+
+void DspChain::add(std::string name, DspStage::Function function)
+{
+    stages.emplace_back(std::move(name), std::move(function));
+}
+
+bool DspChain::run(StageContext &context) const
+{
+    for (const auto &stage : stages)
+    {
+        if (!stage.process(context))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string DspChain::describe() const
+{
+    std::string description;
+    for (const auto &stage : stages)
+    {
+        if (!description.empty())
+        {
+            description += '>';
+        }
+        description += stage.getName();
+    }
+    return description;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "activity_mask.h"
+
+// Per-clip state threaded through the stages of a DspChain.
+// signal holds the current audio; out-of-place stages write scratch and call swap().
+struct StageContext {
+    std::vector<float>* signal = nullptr;
+    std::vector<float>* scratch = nullptr;
+    int sampleRate = 0;
+    size_t validSamples = 0;     // samples of real audio, anything after is padding
+    ActivityMask* activity = nullptr;
+    bool wantActivity = false;   // the caller asked for the speech mask
+
+    void swap() { std::swap(signal, scratch); }
+};
+
+// Ping-pong buffers and mask storage owned by the calling thread. Their capacity
+// survives between clips, so once the largest clip has been seen, running a chain
+// allocates nothing.
+struct StageArena {
+    std::vector<float> front;
+    std::vector<float> back;
+    ActivityMask activity;
+
+    static StageArena& local();
+};
+
+// A named processing step; returns false to reject the clip
+class DspStage {
+public:
+    using Function = std::function<bool(StageContext&)>;
+
+    DspStage(std::string name, Function function) : name(std::move(name)), function(std::move(function)) {}
+
+    const std::string& getName() const { return name; }
+    bool process(StageContext& context) const { return function(context); }
+
+private:
+    std::string name;
+    Function function;
+};
+
+// Ordered list of stages run over one clip
+class DspChain {
+public:
+    void add(std::string name, DspStage::Function function);
+
+    // Runs every stage in order; stops at the first stage that rejects the clip
+    bool run(StageContext& context) const;
+
+    size_t size() const { return stages.size(); }
+
+    // Stage names joined with '>', e.g. "resample>vad>trim>normalize"
+    std::string describe() const;
+
+private:
+    std::vector<DspStage> stages;
+};
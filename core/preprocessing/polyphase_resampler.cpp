@@ -0,0 +1,140 @@
+#include "polyphase_resampler.hpp"
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include "../../utils/simd.hpp"
+
+namespace
+{
+    // -6 dB point of the anti-aliasing filter, as a fraction of the lower of the two rates.
+    // 0.45 puts it at 7.2 kHz for 16 kHz output, leaving the band below ~6.6 kHz flat.
+    const double CUTOFF = 0.45;
+    // Sinc zero crossings on each side of the centre; sets the transition width
+    const int ZERO_CROSSINGS = 32;
+    // Kaiser beta for roughly 80 dB stopband attenuation
+    const double KAISER_BETA = 8.0;
+    // Largest reduced L or M we are willing to build a bank for
+    const int MAX_RATIO_TERM = 4096;
+    const int SIMD_WIDTH = 8;
+
+    // Zeroth-order modified Bessel function of the first kind
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        const double q = x * x / 4.0;
+        for (int k = 1; k < 64; ++k)
+        {
+            term *= q / (static_cast<double>(k) * k);
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+}
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate)
+    : inputRate(inputRate), outputRate(outputRate)
+{
+    const int g = std::gcd(inputRate, outputRate);
+    up = outputRate / g;
+    down = inputRate / g;
+
+    // Prototype filter runs at the upsampled rate inputRate * L
+    const double fc = CUTOFF / std::max(up, down);
+    const long halfLength = static_cast<long>(std::ceil(ZERO_CROSSINGS / (2.0 * fc)));
+    const long length = 2 * halfLength + 1;
+    const int taps = static_cast<int>((length + up - 1) / up);
+    tapsPerPhase = (taps + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    delay = halfLength;
+
+    // h[n] for n in [0, length); phase p holds h[p], h[p + L], ... stored newest-last
+    bank.assign(static_cast<size_t>(up) * tapsPerPhase, 0.0f);
+    const double norm = besselI0(KAISER_BETA);
+    for (long n = 0; n < length; ++n)
+    {
+        const double t = static_cast<double>(n - halfLength);
+        const double x = 2.0 * fc * t;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        const double r = t / halfLength;
+        const double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+        // Gain L restores the amplitude lost to the implicit zero-stuffing
+        const double h = 2.0 * fc * up * sinc * window;
+
+        const long phase = n % up;
+        const long k = n / up;
+        bank[phase * tapsPerPhase + (tapsPerPhase - 1 - k)] = static_cast<float>(h);
+    }
+}
+
+bool PolyphaseResampler::supports(int inputRate, int outputRate)
+{
+    if (inputRate <= 0 || outputRate <= 0)
+        return false;
+    const int g = std::gcd(inputRate, outputRate);
+    return std::max(inputRate, outputRate) / g <= MAX_RATIO_TERM;
+}
+
+const PolyphaseResampler &PolyphaseResampler::forRates(int inputRate, int outputRate)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, std::unique_ptr<PolyphaseResampler>> cache;
+
+    if (!supports(inputRate, outputRate))
+    {
+        throw std::invalid_argument("Unsupported resampling ratio " + std::to_string(inputRate) + " -> " +
+                                    std::to_string(outputRate));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = cache[{inputRate, outputRate}];
+    if (!entry)
+    {
+        entry.reset(new PolyphaseResampler(inputRate, outputRate));
+    }
+    return *entry;
+}
+
+std::vector<float> PolyphaseResampler::process(std::span<const float> input) const
+{
+    std::vector<float> output;
+    process(input, output);
+    return output;
+}
+
+void PolyphaseResampler::process(std::span<const float> input, std::vector<float> &output) const
+{
+    const long length = static_cast<long>(input.size());
+    output.resize((input.size() * up + down - 1) / down);
+
+    // Windows that hang over either end are gathered into a zero-filled copy; everything
+    // else reads the input directly, so no padded duplicate of the signal is built
+    thread_local std::vector<float> edge;
+    edge.resize(tapsPerPhase);
+
+    for (size_t j = 0; j < output.size(); ++j)
+    {
+        // Position of output sample j on the upsampled grid, shifted by the filter delay
+        const long t = static_cast<long>(j) * down + delay;
+        const long newest = t / up;
+        const long phase = t - newest * up;
+        const long oldest = newest - (tapsPerPhase - 1);
+        const float *taps = bank.data() + phase * tapsPerPhase;
+
+        if (oldest >= 0 && newest < length)
+        {
+            output[j] = harmony::dot(taps, input.data() + oldest, tapsPerPhase);
+            continue;
+        }
+        for (long k = 0; k < tapsPerPhase; ++k)
+        {
+            const long i = oldest + k;
+            edge[k] = i >= 0 && i < length ? input[i] : 0.0f;
+        }
+        output[j] = harmony::dot(taps, edge.data(), tapsPerPhase);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Rational-ratio polyphase FIR resampler.
+//
+// The rate change in/out is reduced to L/M (e.g. 48k->16k = 1/3, 44.1k->16k = 160/441)
+// and a Kaiser-windowed sinc low-pass is split into L phases. Each output sample is a
+// single dot product of one phase with the input, so no zero-stuffed intermediate
+// signal is ever built. Filter banks are designed once per rate pair and shared:
+// process() is const and safe to call from several threads at once.
+class PolyphaseResampler {
+public:
+    // Returns the shared resampler for a rate pair, designing its filter bank on first use
+    static const PolyphaseResampler& forRates(int inputRate, int outputRate);
+
+    // False for rate pairs whose reduced ratio would need an unreasonably large filter bank
+    static bool supports(int inputRate, int outputRate);
+
+    // Resamples a whole signal; the filter delay is compensated so output stays aligned
+    std::vector<float> process(std::span<const float> input) const;
+
+    // Same, writing into output; its capacity is reused, so repeated calls stop allocating
+    void process(std::span<const float> input, std::vector<float>& output) const;
+
+    int getInputRate() const { return inputRate; }
+    int getOutputRate() const { return outputRate; }
+    int getTapsPerPhase() const { return tapsPerPhase; }
+
+private:
+    PolyphaseResampler(int inputRate, int outputRate);
+
+    int inputRate;
+    int outputRate;
+    int up;           // L
+    int down;         // M
+    int tapsPerPhase; // padded to a multiple of the SIMD width
+    long delay;       // filter centre, in upsampled samples
+
+    // Phase p occupies [p * tapsPerPhase, (p + 1) * tapsPerPhase), oldest input first
+    std::vector<float> bank;
+};
@@ -0,0 +1,96 @@
+#include "signal_level.hpp"
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Samples reduced in float before folding into the double accumulators
+    const size_t BLOCK = 4096;
+
+#if defined(__SSE__)
+    float horizontalSum(__m128 v)
+    {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+        return _mm_cvtss_f32(v);
+    }
+
+    float horizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 0x55));
+        return _mm_cvtss_f32(v);
+    }
+#endif
+}
+
+void SignalStats::add(const float *samples, size_t n)
+{
+    for (size_t start = 0; start < n; start += BLOCK)
+    {
+        const size_t end = std::min(n, start + BLOCK);
+        size_t i = start;
+        float blockSum = 0.0f, blockSquares = 0.0f, blockPeak = 0.0f;
+#if defined(__SSE__)
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 s = _mm_setzero_ps(), sq = _mm_setzero_ps(), pk = _mm_setzero_ps();
+        for (; i + 4 <= end; i += 4)
+        {
+            const __m128 v = _mm_loadu_ps(samples + i);
+            s = _mm_add_ps(s, v);
+            sq = _mm_add_ps(sq, _mm_mul_ps(v, v));
+            pk = _mm_max_ps(pk, _mm_andnot_ps(signMask, v));
+        }
+        blockSum = horizontalSum(s);
+        blockSquares = horizontalSum(sq);
+        blockPeak = horizontalMax(pk);
+#endif
+        for (; i < end; ++i)
+        {
+            blockSum += samples[i];
+            blockSquares += samples[i] * samples[i];
+            blockPeak = std::max(blockPeak, std::abs(samples[i]));
+        }
+        sum += blockSum;
+        sumSquares += blockSquares;
+        peak = std::max(peak, blockPeak);
+    }
+    count += n;
+}
+
+SignalStats SignalLevel::measure(const float *samples, size_t n)
+{
+    SignalStats stats;
+    stats.add(samples, n);
+    return stats;
+}
+
+void SignalLevel::applyGain(float *samples, size_t n, float gain, float offset, float limit)
+{
+    size_t i = 0;
+#if defined(__AVX__)
+    const __m256 g8 = _mm256_set1_ps(gain), o8 = _mm256_set1_ps(offset);
+    const __m256 hi8 = _mm256_set1_ps(limit), lo8 = _mm256_set1_ps(-limit);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(samples + i), o8), g8);
+        _mm256_storeu_ps(samples + i, _mm256_min_ps(_mm256_max_ps(v, lo8), hi8));
+    }
+#endif
+#if defined(__SSE__)
+    const __m128 g4 = _mm_set1_ps(gain), o4 = _mm_set1_ps(offset);
+    const __m128 hi4 = _mm_set1_ps(limit), lo4 = _mm_set1_ps(-limit);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(samples + i), o4), g4);
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(v, lo4), hi4));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        samples[i] = std::clamp((samples[i] - offset) * gain, -limit, limit);
+    }
+}
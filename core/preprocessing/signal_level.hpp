@@ -0,0 +1,35 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Running level statistics of a signal. Blocks are reduced with SIMD in float and
+// folded into double accumulators, so long clips do not lose precision and a stream
+// can be measured chunk by chunk with add().
+struct SignalStats {
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    float peak = 0.0f;
+    size_t count = 0;
+
+    void add(const float* samples, size_t n);
+
+    double mean() const { return count ? sum / count : 0.0; }
+    double rms() const { return count ? std::sqrt(sumSquares / count) : 0.0; }
+
+    // RMS after removing the DC offset
+    double acRms() const {
+        if (!count) return 0.0;
+        const double m = mean();
+        return std::sqrt(std::max(0.0, sumSquares / count - m * m));
+    }
+};
+
+class SignalLevel {
+public:
+    // One pass: sum, sum of squares and absolute peak
+    static SignalStats measure(const float* samples, size_t n);
+
+    // One fused pass: y = clamp((x - offset) * gain, -limit, limit)
+    static void applyGain(float* samples, size_t n, float gain, float offset, float limit);
+};
@@ -0,0 +1,186 @@
+#include "spectral_denoiser.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <fftw3.h>
+#include "../../utils/fftw_planner.hpp"
+
+namespace
+{
+    // Smoothing of the decision-directed a-priori SNR estimate (Ephraim & Malah)
+    const float DD_ALPHA = 0.98f;
+    // Share of the quietest frames used for the noise profile when too few fall under the threshold
+    const float QUIET_FRAME_SHARE = 0.1f;
+
+    // Per-thread FFT plans, window and scratch space for one frame size
+    struct Workspace
+    {
+        int size;
+        float *time;
+        fftwf_complex *freq;
+        fftwf_plan forward;
+        fftwf_plan inverse;
+        std::vector<float> window;
+
+        // Grown on demand and kept, so steady-state processing does not allocate
+        std::vector<float> signal;
+        std::vector<float> output;
+        std::vector<std::complex<float>> spectra;
+        std::vector<float> frameEnergy;
+        std::vector<float> noisePower;
+        std::vector<float> cleanPower;
+        std::vector<int> order;
+
+        explicit Workspace(int size) : size(size), window(size)
+        {
+            // Periodic sqrt-Hann: applied at analysis and synthesis, its square sums to 1 at 50% overlap
+            for (int i = 0; i < size; ++i)
+            {
+                window[i] = std::sqrt(0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / size)));
+            }
+
+            auto lock = harmony::FftwPlanner::lock();
+            harmony::FftwPlanner::importWisdom();
+            time = fftwf_alloc_real(size);
+            freq = fftwf_alloc_complex(size / 2 + 1);
+            forward = fftwf_plan_dft_r2c_1d(size, time, freq, FFTW_MEASURE);
+            inverse = fftwf_plan_dft_c2r_1d(size, freq, time, FFTW_MEASURE);
+            harmony::FftwPlanner::exportWisdom();
+        }
+
+        ~Workspace()
+        {
+            auto lock = harmony::FftwPlanner::lock();
+            fftwf_destroy_plan(forward);
+            fftwf_destroy_plan(inverse);
+            fftwf_free(time);
+            fftwf_free(freq);
+        }
+
+        Workspace(const Workspace &) = delete;
+        Workspace &operator=(const Workspace &) = delete;
+    };
+
+    Workspace &workspaceFor(int frameSize)
+    {
+        thread_local std::map<int, std::unique_ptr<Workspace>> workspaces;
+        auto &workspace = workspaces[frameSize];
+        if (!workspace)
+        {
+            workspace = std::make_unique<Workspace>(frameSize);
+        }
+        return *workspace;
+    }
+}
+
+SpectralDenoiser::SpectralDenoiser(int frameSize)
+    : frameSize(frameSize)
+{
+    if (frameSize < 16 || frameSize % 2 != 0)
+    {
+        throw std::invalid_argument("SpectralDenoiser frame size must be even and at least 16");
+    }
+}
+
+void SpectralDenoiser::process(std::vector<float> &audio, size_t length) const
+{
+    length = std::min(length, audio.size());
+    if (length == 0)
+    {
+        return;
+    }
+
+    Workspace &ws = workspaceFor(frameSize);
+    const float *window = ws.window.data();
+    const int hop = frameSize / 2;
+    const int bins = frameSize / 2 + 1;
+
+    // One hop of leading padding so every input sample is covered by exactly two frames
+    const size_t frames = (length + hop - 1) / hop + 1;
+    const size_t paddedLength = (frames + 1) * hop;
+    ws.signal.assign(paddedLength, 0.0f);
+    std::copy(audio.begin(), audio.begin() + length, ws.signal.begin() + hop);
+
+    // Analysis: keep every frame's spectrum, the noise profile needs the whole clip first
+    ws.spectra.resize(frames * bins);
+    ws.frameEnergy.resize(frames);
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const float *src = ws.signal.data() + f * hop;
+        float energy = 0.0f;
+        for (int i = 0; i < frameSize; ++i)
+        {
+            ws.time[i] = src[i] * window[i];
+            energy += ws.time[i] * ws.time[i];
+        }
+        ws.frameEnergy[f] = energy;
+
+        fftwf_execute(ws.forward);
+        std::complex<float> *spectrum = ws.spectra.data() + f * bins;
+        for (int k = 0; k < bins; ++k)
+        {
+            spectrum[k] = {ws.freq[k][0], ws.freq[k][1]};
+        }
+    }
+
+    // Noise profile: frames under the threshold, or the quietest share of the clip.
+    // Windowed energy / sum(w^2) is the frame's mean square; sum(w^2) = frameSize / 2.
+    const float thresholdEnergy = noiseThreshold * noiseThreshold * frameSize / 2.0f;
+    const size_t minNoiseFrames = std::max<size_t>(1, static_cast<size_t>(frames * QUIET_FRAME_SHARE));
+    ws.order.resize(frames);
+    std::iota(ws.order.begin(), ws.order.end(), 0);
+    auto quieter = [&](int a, int b) { return ws.frameEnergy[a] < ws.frameEnergy[b]; };
+
+    size_t noiseFrames = std::count_if(ws.frameEnergy.begin(), ws.frameEnergy.end(),
+                                       [&](float e) { return e < thresholdEnergy; });
+    noiseFrames = std::max(noiseFrames, minNoiseFrames);
+    std::nth_element(ws.order.begin(), ws.order.begin() + (noiseFrames - 1), ws.order.end(), quieter);
+
+    ws.noisePower.assign(bins, 0.0f);
+    for (size_t i = 0; i < noiseFrames; ++i)
+    {
+        const std::complex<float> *spectrum = ws.spectra.data() + static_cast<size_t>(ws.order[i]) * bins;
+        for (int k = 0; k < bins; ++k)
+        {
+            ws.noisePower[k] += std::norm(spectrum[k]);
+        }
+    }
+    for (auto &p : ws.noisePower)
+    {
+        p = p / noiseFrames + 1e-12f;
+    }
+
+    // Wiener gain per bin, then weighted overlap-add with the same window
+    ws.output.assign(paddedLength, 0.0f);
+    ws.cleanPower.assign(bins, 0.0f);
+    const float scale = 1.0f / frameSize; // FFTW's inverse is unnormalised
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const std::complex<float> *spectrum = ws.spectra.data() + f * bins;
+        for (int k = 0; k < bins; ++k)
+        {
+            const float power = std::norm(spectrum[k]);
+            const float posteriorSnr = power / ws.noisePower[k];
+            const float prioriSnr = DD_ALPHA * ws.cleanPower[k] / ws.noisePower[k] +
+                                    (1.0f - DD_ALPHA) * std::max(posteriorSnr - 1.0f, 0.0f);
+            const float gain = std::max(prioriSnr / (1.0f + prioriSnr), gainFloor);
+            ws.cleanPower[k] = gain * gain * power;
+            ws.freq[k][0] = gain * spectrum[k].real();
+            ws.freq[k][1] = gain * spectrum[k].imag();
+        }
+
+        fftwf_execute(ws.inverse);
+        float *dst = ws.output.data() + f * hop;
+        for (int i = 0; i < frameSize; ++i)
+        {
+            dst[i] += ws.time[i] * window[i] * scale;
+        }
+    }
+
+    std::copy(ws.output.begin() + hop, ws.output.begin() + hop + length, audio.begin());
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// STFT-domain noise reducer.
+//
+// Frames are analysed with a square-root Hann window at 50% overlap and resynthesised
+// with the same window, so with unity gain the weighted overlap-add reconstructs the
+// input exactly. The noise power spectrum is estimated from the quietest frames of the
+// clip and each bin is scaled by a Wiener gain driven by a decision-directed a-priori
+// SNR estimate, which keeps "musical noise" down compared to hard spectral gating.
+//
+// FFTW plans, the window and scratch buffers live in a per-thread workspace that is
+// reused across frames and files, so a denoiser is cheap to construct and holds only its
+// settings; process() is const and may be called from several threads.
+class SpectralDenoiser {
+public:
+    explicit SpectralDenoiser(int frameSize = 512);
+
+    // Frames whose RMS is below this level are treated as noise when estimating the profile
+    void setNoiseThreshold(float threshold) { noiseThreshold = threshold; }
+
+    // Lower bound on the per-bin gain (0.1 = -20 dB); keeps some residual noise for naturalness
+    void setGainFloor(float floor) { gainFloor = floor; }
+
+    // Denoises audio[0, length) in place; samples past length (e.g. trimAudio's zero
+    // padding) are neither part of the noise profile nor written
+    void process(std::vector<float>& audio, size_t length) const;
+    void process(std::vector<float>& audio) const { process(audio, audio.size()); }
+
+    int getFrameSize() const { return frameSize; }
+    int getHopSize() const { return frameSize / 2; }
+
+private:
+    int frameSize;
+    float noiseThreshold = 0.01f;
+    float gainFloor = 0.1f;
+};
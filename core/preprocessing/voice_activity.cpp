@@ -0,0 +1,166 @@
+#include "voice_activity.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Noise floor = this percentile of frame RMS values
+    const float NOISE_PERCENTILE = 0.1f;
+    // Speech must sit at least this far above the noise floor (2x = 6 dB)
+    const float MIN_SNR = 2.0f;
+    // ...but never more than this (3x = ~10 dB), so quiet speakers survive a strict absolute level
+    const float MAX_SNR = 3.0f;
+    // Anything under -80 dBFS is silence regardless of the floor
+    const float ABSOLUTE_FLOOR = 1e-4f;
+    // Unvoiced fricatives: low energy but many zero crossings per sample
+    const float FRICATIVE_ZCR = 0.3f;
+    // Frames kept before an onset, to keep plosive attacks
+    const int ONSET_FRAMES = 2;
+
+    float sumSquares(const float *x, int n)
+    {
+        int i = 0;
+        float sum = 0.0f;
+#if defined(__SSE__)
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 v = _mm_loadu_ps(x + i);
+            acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+        }
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+        sum = _mm_cvtss_f32(acc);
+#endif
+        for (; i < n; ++i)
+            sum += x[i] * x[i];
+        return sum;
+    }
+
+    int zeroCrossings(const float *x, int n)
+    {
+        int count = 0;
+        for (int i = 1; i < n; ++i)
+            count += (x[i - 1] >= 0.0f) != (x[i] >= 0.0f);
+        return count;
+    }
+}
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate, int frameMs)
+    : sampleRate(sampleRate), frameSize(std::max(1, sampleRate * frameMs / 1000))
+{
+}
+
+int VoiceActivityDetector::msToFrames(int ms) const
+{
+    return std::max(0, static_cast<int>(static_cast<long>(ms) * sampleRate / 1000 / frameSize));
+}
+
+ActivityMask VoiceActivityDetector::detect(const std::vector<float> &audio) const
+{
+    ActivityMask mask;
+    detect(audio, mask);
+    return mask;
+}
+
+void VoiceActivityDetector::detect(const std::vector<float> &audio, ActivityMask &mask) const
+{
+    mask.frameSize = frameSize;
+    mask.validSamples = audio.size();
+    const size_t frames = (audio.size() + frameSize - 1) / frameSize;
+    mask.active.assign(frames, 0);
+    if (frames == 0)
+        return;
+
+    thread_local std::vector<float> rms, zcr, sorted;
+    thread_local std::vector<uint8_t> raw;
+    rms.resize(frames);
+    zcr.resize(frames);
+    for (size_t f = 0; f < frames; ++f)
+    {
+        const size_t start = f * frameSize;
+        const int n = static_cast<int>(std::min<size_t>(frameSize, audio.size() - start));
+        rms[f] = std::sqrt(sumSquares(audio.data() + start, n) / n);
+        zcr[f] = n > 1 ? static_cast<float>(zeroCrossings(audio.data() + start, n)) / (n - 1) : 0.0f;
+    }
+
+    // Adaptive threshold: the absolute level, clamped to 2x..3x the noise floor
+    sorted.assign(rms.begin(), rms.end());
+    const size_t k = static_cast<size_t>(NOISE_PERCENTILE * (frames - 1));
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    const float noiseFloor = sorted[k];
+    const float threshold = std::max({ABSOLUTE_FLOOR, noiseFloor * MIN_SNR,
+                                      std::min(energyThreshold, noiseFloor * MAX_SNR)});
+
+    raw.resize(frames);
+    for (size_t f = 0; f < frames; ++f)
+    {
+        raw[f] = rms[f] > threshold || (rms[f] > 0.5f * threshold && zcr[f] > FRICATIVE_ZCR);
+    }
+
+    // Drop isolated bursts (clicks, pops) shorter than the minimum speech length
+    const size_t minSpeech = std::max(1, msToFrames(minSpeechMs));
+    for (size_t f = 0; f < frames;)
+    {
+        if (!raw[f])
+        {
+            ++f;
+            continue;
+        }
+        size_t end = f;
+        while (end < frames && raw[end])
+            ++end;
+        if (end - f < minSpeech)
+            std::fill(raw.begin() + f, raw.begin() + end, 0);
+        f = end;
+    }
+
+    // Hangover after every active frame, a short pre-roll before it
+    const size_t hangover = msToFrames(hangoverMs);
+    for (size_t f = 0; f < frames; ++f)
+    {
+        if (!raw[f])
+            continue;
+        const size_t from = f >= ONSET_FRAMES ? f - ONSET_FRAMES : 0;
+        const size_t to = std::min(frames, f + hangover + 1);
+        std::fill(mask.active.begin() + from, mask.active.begin() + to, 1);
+    }
+}
+
+void VoiceActivityDetector::compact(std::vector<float> &audio, ActivityMask &mask) const
+{
+    const size_t frames = mask.active.size();
+    const size_t minSilence = std::max(1, msToFrames(minSilenceMs));
+
+    // Keep every frame except those in inactive runs of at least minSilence frames
+    size_t writeSample = 0;
+    size_t writeFrame = 0;
+    for (size_t f = 0; f < frames;)
+    {
+        size_t end = f + 1;
+        while (end < frames && mask.active[end] == mask.active[f])
+            ++end;
+
+        const bool drop = !mask.active[f] && end - f >= minSilence;
+        if (!drop)
+        {
+            const size_t begin = f * frameSize;
+            const size_t stop = std::min(audio.size(), end * frameSize);
+            if (writeSample != begin)
+                std::memmove(audio.data() + writeSample, audio.data() + begin, (stop - begin) * sizeof(float));
+            writeSample += stop - begin;
+            for (size_t i = f; i < end; ++i)
+                mask.active[writeFrame++] = mask.active[i];
+        }
+        f = end;
+    }
+
+    audio.resize(writeSample);
+    mask.active.resize(writeFrame);
+    mask.validSamples = writeSample;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "activity_mask.h"
+
+// Frame-based voice activity detector (short-time energy + zero-crossing rate).
+//
+// Each 20 ms frame is compared against an adaptive threshold derived from the clip's
+// own noise floor, so quiet speakers are not cut and a single click cannot bridge a
+// pause: active runs shorter than the minimum speech length are discarded, and the
+// surviving runs are extended by a hangover so word endings are kept.
+class VoiceActivityDetector {
+public:
+    explicit VoiceActivityDetector(int sampleRate, int frameMs = 20);
+
+    // Absolute RMS above which a frame always counts as speech (unless the clip is noisier)
+    void setEnergyThreshold(float threshold) { energyThreshold = threshold; }
+    // Pauses at least this long are removed by compact(); shorter ones are kept
+    void setMinSilenceMs(int ms) { minSilenceMs = ms; }
+    void setHangoverMs(int ms) { hangoverMs = ms; }
+    void setMinSpeechMs(int ms) { minSpeechMs = ms; }
+
+    ActivityMask detect(const std::vector<float>& audio) const;
+
+    // Same, refilling mask in place; per-frame scratch is kept per thread, so repeated
+    // calls stop allocating once the longest clip has been seen
+    void detect(const std::vector<float>& audio, ActivityMask& mask) const;
+
+    // Removes inactive runs of at least minSilenceMs from audio in place and drops the
+    // matching frames from mask, which then describes the compacted signal
+    void compact(std::vector<float>& audio, ActivityMask& mask) const;
+
+private:
+    int sampleRate;
+    int frameSize;
+    float energyThreshold = 0.01f;
+    int minSilenceMs = 500;
+    int hangoverMs = 200;
+    int minSpeechMs = 60;
+
+    int msToFrames(int ms) const;
+};
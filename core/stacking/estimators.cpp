@@ -1,21 +1,41 @@
 #include "../../include/knn.h"
 #include "estimators.hpp"
+#include "../../utils/logger.hpp"
 #include <omp.h>
+#include <thread>
+#include <random>
+#include <numeric>
+#include <limits>
+#include <functional>
+#include <sstream>
+#include <iomanip>
 
 namespace harmony
 {
     //--------------------------------------------------------------------------------------
     //-----------------------------SVM Classifier-------------------------------------------
     //--------------------------------------------------------------------------------------
-    SVM::SVM(double C, double gamma)
+    SVM::SVM(double C, double gamma, unsigned long numThreads, long cacheSize)
+        : numThreads_(numThreads)
     {
         rbf_trainer.set_c(C);
         rbf_trainer.set_kernel(kernel_type(gamma));
+        rbf_trainer.set_cache_size(cacheSize);
+
+        // The one-vs-one trainer copies the binary trainer, so it has to be fully
+        // configured first. Each pair of classes is an independent problem and
+        // dlib trains them concurrently on its own thread pool.
         ovo_trainer.set_trainer(rbf_trainer);
     }
 
     void SVM::train(const MatrixXd &X, const VectorXi &y)
     {
+        // StackingClassifier::fit trains the base models in an OpenMP team; by default
+        // dlib's pool gets this thread's share of the cores, so they are not oversubscribed
+        unsigned long threads = numThreads_;
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency() / static_cast<unsigned>(std::max(1, omp_get_num_threads())));
+        ovo_trainer.set_num_threads(threads);
 
         std::vector<sample_type> samples;
         std::vector<int> labels;
@@ -399,27 +419,104 @@ namespace harmony
     //--------------------------------------------------------------------------------------
     //-----------------------------Neural Network Classifier--------------------------------
     //--------------------------------------------------------------------------------------
-    NeuralNet::NeuralNet(std::size_t hiddenUnits1, std::size_t hiddenUnits2, std::size_t nClasses)
-        : hiddenUnits1_(hiddenUnits1), hiddenUnits2_(hiddenUnits2), nClasses_(nClasses), inputDim_(0)
+    namespace
+    {
+        // Float32 only reorders the sums, so it has to match mlpack almost exactly; int8 is
+        // judged on the predictions it changes
+        constexpr double MAX_FUSED_PROB_DIFF = 1e-3;
+        constexpr double MIN_INT8_AGREEMENT = 0.98;
+
+        /**
+         * @brief ensmallen callback that logs per-epoch losses and stops on a
+         * validation plateau, remembering the best parameters seen so far
+         */
+        class ValidationEarlyStop
+        {
+        public:
+            ValidationEarlyStop(std::function<double()> validationLoss, std::size_t nTrain,
+                                std::size_t patience, arma::mat &bestParameters)
+                : validationLoss_(std::move(validationLoss)), nTrain_(nTrain),
+                  patience_(patience), bestParameters_(bestParameters) {}
+
+            template <typename OptimizerType, typename FunctionType, typename MatType>
+            bool EndEpoch(OptimizerType &, FunctionType &, const MatType &coordinates,
+                          const std::size_t epoch, const double objective)
+            {
+                std::ostringstream msg;
+                msg << std::fixed << std::setprecision(4)
+                    << "NeuralNet epoch " << epoch << ": train loss " << objective / nTrain_;
+
+                if (!validationLoss_)
+                {
+                    Logger::getInstance().log(msg.str(), Logger::Level::INFO);
+                    return false;
+                }
+
+                const double loss = validationLoss_();
+                msg << ", validation loss " << loss;
+                Logger::getInstance().log(msg.str(), Logger::Level::INFO);
+
+                if (loss < bestLoss_)
+                {
+                    bestLoss_ = loss;
+                    bestParameters_ = coordinates;
+                    stale_ = 0;
+                    return false;
+                }
+                return ++stale_ >= patience_;
+            }
+
+        private:
+            std::function<double()> validationLoss_;
+            std::size_t nTrain_;
+            std::size_t patience_;
+            arma::mat &bestParameters_;
+            double bestLoss_ = std::numeric_limits<double>::max();
+            std::size_t stale_ = 0;
+        };
+    }
+
+    NeuralNet::NeuralNet(std::size_t hiddenUnits1, std::size_t hiddenUnits2, std::size_t nClasses,
+                         NeuralNetConfig config)
+        : config_(std::move(config)), hiddenUnits1_(hiddenUnits1), hiddenUnits2_(hiddenUnits2),
+          nClasses_(nClasses), inputDim_(0)
     {
+        if (config_.optimizer != "adam" && config_.optimizer != "sgd")
+            throw std::invalid_argument("Unknown optimizer: " + config_.optimizer);
+        if (config_.batchSize < 1 || config_.epochs < 1)
+            throw std::invalid_argument("Batch size and epochs must be at least 1");
     }
 
     void NeuralNet::train(const MatrixXd &X, const VectorXi &y)
     {
-        // Convert input to mlpack format from samples * features to features * samples
-        arma::mat data(X.cols(), X.rows());
-        for (size_t i = 0; i < X.rows(); ++i)
-        {
-            for (size_t j = 0; j < X.cols(); ++j)
+        const std::size_t n = X.rows();
+
+        // Hold out a validation fold for early stopping
+        std::vector<std::size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::mt19937 rng(config_.seed);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        std::size_t nVal = 0;
+        if (config_.validationSplit > 0.0 && config_.patience > 0)
+            nVal = std::min<std::size_t>(n - 1, static_cast<std::size_t>(n * config_.validationSplit));
+        const std::size_t nTrain = n - nVal;
+
+        // Convert input to mlpack format from samples * features to features * samples.
+        // NegativeLogLikelihood expects a single row of class indices as responses.
+        arma::mat trainData(X.cols(), nTrain), valData(X.cols(), nVal);
+        arma::mat trainLabels(1, nTrain), valLabels(1, nVal);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t src = order[i];
+            arma::mat &data = i < nTrain ? trainData : valData;
+            arma::mat &labels = i < nTrain ? trainLabels : valLabels;
+            const std::size_t col = i < nTrain ? i : i - nTrain;
+            for (std::size_t j = 0; j < static_cast<std::size_t>(X.cols()); ++j)
             {
-                data(j, i) = X(i, j);
+                data(j, col) = X(src, j);
             }
-        }
-
-        arma::Row<size_t> labels(y.size());
-        for (size_t i = 0; i < y.size(); ++i)
-        {
-            labels[i] = static_cast<size_t>(y(i));
+            labels(0, col) = static_cast<double>(y(src));
         }
 
         inputDim_ = X.cols();
@@ -432,14 +529,150 @@ namespace harmony
         model_.Add<mlpack::Linear>(nClasses_);
         model_.Add<mlpack::LogSoftMax>();
 
+        std::function<double()> validationLoss;
+        if (nVal > 0)
+        {
+            validationLoss = [&]() { return model_.Evaluate(valData, valLabels) / nVal; };
+        }
+
+        arma::mat bestParameters;
+        ValidationEarlyStop earlyStop(validationLoss, nTrain, config_.patience, bestParameters);
+
+        // ensmallen counts iterations in samples, so this bounds the number of epochs
+        const std::size_t maxIterations = config_.epochs * nTrain;
+        const std::size_t batchSize = std::min(config_.batchSize, nTrain);
 
         // Train the model
-        arma::mat oneHotLabels;
-        mlpack::data::OneHotEncoding(labels, oneHotLabels);
-        model_.Train(data, oneHotLabels);
+        if (config_.optimizer == "sgd")
+        {
+            ens::MomentumSGD optimizer(config_.learningRate, batchSize, maxIterations, 1e-8, true,
+                                       ens::MomentumUpdate(config_.momentum));
+            model_.Train(trainData, trainLabels, optimizer, earlyStop);
+        }
+        else
+        {
+            ens::Adam optimizer(config_.learningRate, batchSize, 0.9, 0.999, 1e-8, maxIterations, 1e-8, true);
+            model_.Train(trainData, trainLabels, optimizer, earlyStop);
+        }
+
+        // Roll back to the epoch with the lowest validation loss
+        if (!bestParameters.is_empty())
+            model_.Parameters() = bestParameters;
+
+        exportFusedWeights();
+        if (inferenceMode_ == InferenceMode::MLPACK)
+            return;
+        if (fused_.empty())
+        {
+            inferenceMode_ = InferenceMode::MLPACK;
+            return;
+        }
+
+        // Int8 ranges come from the training inputs; the fused backend is only kept if it
+        // reproduces mlpack's predictions on them
+        fused_.calibrate(X);
+        const FusedAgreement agreement = checkFusedAgreement(X);
+        std::ostringstream msg;
+        msg << "NeuralNet " << inferenceModeName(inferenceMode_) << " inference vs mlpack: "
+            << std::fixed << std::setprecision(2) << agreement.argmaxAgreement * 100.0 << "% argmax agreement, "
+            << std::scientific << agreement.maxProbDiff << " max probability difference";
+        Logger::getInstance().log(msg.str(), Logger::Level::INFO);
+        const bool accurate = inferenceMode_ == InferenceMode::FUSED
+                                  ? agreement.maxProbDiff <= MAX_FUSED_PROB_DIFF
+                                  : agreement.argmaxAgreement >= MIN_INT8_AGREEMENT;
+        if (!accurate)
+        {
+            Logger::getInstance().log("NeuralNet: " + inferenceModeName(inferenceMode_) +
+                                          " inference disagrees with mlpack, falling back to mlpack inference",
+                                      Logger::Level::WARN);
+            inferenceMode_ = InferenceMode::MLPACK;
+        }
     }
 
-    void NeuralNet::predict(const MatrixXd& X, VectorXi& y_pred)
+    NeuralNet::InferenceMode NeuralNet::inferenceModeFromString(const std::string &name)
+    {
+        if (name == "mlpack")
+            return InferenceMode::MLPACK;
+        if (name == "fused")
+            return InferenceMode::FUSED;
+        if (name == "int8")
+            return InferenceMode::FUSED_INT8;
+        throw std::invalid_argument("Unknown inference mode: " + name);
+    }
+
+    std::string NeuralNet::inferenceModeName(InferenceMode mode)
+    {
+        switch (mode)
+        {
+        case InferenceMode::MLPACK:
+            return "mlpack";
+        case InferenceMode::FUSED:
+            return "fused";
+        case InferenceMode::FUSED_INT8:
+            return "int8";
+        }
+        return "mlpack";
+    }
+
+    NeuralNet::FusedAgreement NeuralNet::checkFusedAgreement(const MatrixXd &X)
+    {
+        FusedAgreement agreement;
+        if (X.rows() == 0 || fused_.empty())
+            return agreement;
+
+        const MatrixXd reference = mlpackLogProbs(X);
+        FusedMLP::MatrixXfRM logProbs;
+        fused_.forward(X, logProbs, inferenceMode_ == InferenceMode::FUSED_INT8
+                                        ? FusedMLP::Precision::INT8
+                                        : FusedMLP::Precision::FLOAT32);
+
+        Eigen::Index same = 0;
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+        {
+            Eigen::Index expected, actual;
+            reference.row(i).maxCoeff(&expected);
+            logProbs.row(i).maxCoeff(&actual);
+            same += expected == actual;
+            const double diff = (reference.row(i).array().exp() -
+                                 logProbs.row(i).cast<double>().array().exp()).abs().maxCoeff();
+            agreement.maxProbDiff = std::max(agreement.maxProbDiff, diff);
+        }
+        agreement.argmaxAgreement = static_cast<double>(same) / X.rows();
+        return agreement;
+    }
+
+    void NeuralNet::exportFusedWeights()
+    {
+        // mlpack stores the parameters of each Linear layer contiguously as a
+        // column-major (outputs x inputs) weight matrix followed by the bias.
+        const arma::mat &params = model_.Parameters();
+        const std::size_t dims[] = {inputDim_, hiddenUnits1_, hiddenUnits2_, nClasses_};
+
+        std::size_t expected = 0;
+        for (int l = 0; l < 3; ++l)
+            expected += dims[l + 1] * dims[l] + dims[l + 1];
+
+        fused_.clear();
+        if (params.n_elem != expected)
+        {
+            std::cerr << "NeuralNet: unexpected parameter count " << params.n_elem
+                      << " (expected " << expected << "), using mlpack inference" << std::endl;
+            return;
+        }
+
+        std::size_t offset = 0;
+        for (int l = 0; l < 3; ++l)
+        {
+            const Eigen::Index in = dims[l], out = dims[l + 1];
+            Eigen::Map<const Eigen::MatrixXd> weights(params.memptr() + offset, out, in);
+            offset += out * in;
+            Eigen::Map<const Eigen::VectorXd> bias(params.memptr() + offset, out);
+            offset += out;
+            fused_.addLayer(weights.cast<float>(), bias.cast<float>());
+        }
+    }
+
+    MatrixXd NeuralNet::mlpackLogProbs(const MatrixXd &X)
     {
         // Convert Eigen matrix (nSamples x nFeatures) to arma::mat (nFeatures x nSamples)
         arma::mat testData(X.cols(), X.rows());
@@ -450,17 +683,32 @@ namespace harmony
                 testData(j, i) = X(i, j);
             }
         }
-    
+
         arma::mat predictionScores;
-        int batchSize = 32; 
         model_.Predict(testData, predictionScores, 32);  // Each column = log probs for a sample
-    
+
+        return Eigen::Map<const MatrixXd>(predictionScores.memptr(), predictionScores.n_rows,
+                                          predictionScores.n_cols).transpose();
+    }
+
+    void NeuralNet::predict(const MatrixXd& X, VectorXi& y_pred)
+    {
+        if (inferenceMode_ != InferenceMode::MLPACK && !fused_.empty())
+        {
+            fused_.predict(X, y_pred, inferenceMode_ == InferenceMode::FUSED_INT8
+                                          ? FusedMLP::Precision::INT8
+                                          : FusedMLP::Precision::FLOAT32);
+            return;
+        }
+
+        const MatrixXd logProbs = mlpackLogProbs(X);
+
         // Extract the class with the highest log probability
-        y_pred = VectorXi::Zero(predictionScores.n_cols);
-        for (size_t i = 0; i < predictionScores.n_cols; ++i)
+        y_pred = VectorXi::Zero(logProbs.rows());
+        for (Eigen::Index i = 0; i < logProbs.rows(); ++i)
         {
-            arma::uword maxIndex;
-            predictionScores.col(i).max(maxIndex);  // Find index of max log-prob
+            Eigen::Index maxIndex;
+            logProbs.row(i).maxCoeff(&maxIndex);
             y_pred(i) = static_cast<int>(maxIndex);
         }
     }
@@ -482,6 +730,17 @@ namespace harmony
                 paramFile << "hiddenUnits2=" << hiddenUnits2_ << std::endl;
                 paramFile << "nClasses=" << nClasses_ << std::endl;
                 paramFile << "inputDim=" << inputDim_ << std::endl;
+                paramFile << "inferenceMode=" << inferenceModeName(inferenceMode_) << std::endl;
+
+                // Int8 activation ranges, one line per layer
+                const auto scales = fused_.activationScales();
+                for (size_t l = 0; l < scales.size() && fused_.calibrated(); ++l)
+                {
+                    paramFile << "activationScales" << l + 1 << "=";
+                    for (size_t k = 0; k < scales[l].size(); ++k)
+                        paramFile << (k ? "," : "") << std::setprecision(9) << scales[l][k];
+                    paramFile << std::endl;
+                }
                 paramFile.close();
                 return true;
             }
@@ -498,9 +757,11 @@ namespace harmony
     {
         try
         {
-            // First load parameters
+            // First load parameters; models saved before the fused backend have no inference mode
             std::ifstream paramFile(directory + "/NeuralNet_params.txt");
             std::string line;
+            std::vector<std::vector<float>> activationScales;
+            inferenceMode_ = InferenceMode::MLPACK;
 
             while (std::getline(paramFile, line))
             {
@@ -520,6 +781,18 @@ namespace harmony
                 {
                     inputDim_ = std::stoi(line.substr(9));
                 }
+                else if (line.find("inferenceMode=") == 0)
+                {
+                    inferenceMode_ = inferenceModeFromString(line.substr(14));
+                }
+                else if (line.find("activationScales") == 0)
+                {
+                    std::istringstream values(line.substr(line.find('=') + 1));
+                    std::string value;
+                    activationScales.emplace_back();
+                    while (std::getline(values, value, ','))
+                        activationScales.back().push_back(std::stof(value));
+                }
             }
 
             // Recreate the model architecture
@@ -536,6 +809,14 @@ namespace harmony
             std::string filepath = directory + "/NeuralNet_model.bin";
             mlpack::data::Load(filepath, "NeuralNet", model_, true, mlpack::data::format::binary);
 
+            exportFusedWeights();
+            if (!activationScales.empty() && !fused_.empty())
+                fused_.setActivationScales(activationScales);
+            if (inferenceMode_ == InferenceMode::FUSED_INT8 && !fused_.calibrated())
+            {
+                std::cerr << "NeuralNet: no int8 activation scales saved, using float32 fused inference" << std::endl;
+                inferenceMode_ = InferenceMode::FUSED;
+            }
             return true;
         }
         catch (const std::exception &e)
@@ -10,6 +10,7 @@
 #include <dlib/serialize.h>
 #include <eigen3/Eigen/Dense>
 #include "stacking_classifier.hpp"
+#include "fused_mlp.hpp"
 #include <cereal/archives/binary.hpp>
 #include <mlpack/core.hpp>
 #include <mlpack/methods/softmax_regression/softmax_regression.hpp>
@@ -71,8 +72,11 @@ namespace harmony
 		 * @brief Constructs SVM with specified parameters
 		 * @param C Regularization parameter
 		 * @param gamma Kernel parameter for RBF
+		 * @param numThreads Threads used to train the pairwise problems (0 = the cores
+		 * divided by the OpenMP team training it, i.e. all cores when trained alone)
+		 * @param cacheSize Number of kernel rows cached per binary problem
 		 */
-		SVM(double C = 1.0, double gamma = 0.01);
+		SVM(double C = 1.0, double gamma = 0.01, unsigned long numThreads = 0, long cacheSize = 200);
 
 		/**
 		 * @brief Trains the SVM model
@@ -104,6 +108,7 @@ namespace harmony
 
 
 	private:
+		unsigned long numThreads_;
 		df_type decision_function_;
 	};
 
@@ -299,20 +304,55 @@ namespace harmony
 		mlpack::SoftmaxRegression<> model_;
 	};
 
+	/**
+	 * @brief Training schedule for NeuralNet
+	 */
+	struct NeuralNetConfig
+	{
+		std::string optimizer = "adam";   // "adam" or "sgd" (SGD with momentum)
+		double learningRate = 0.001;      // Optimizer step size
+		double momentum = 0.9;            // Momentum for "sgd"
+		std::size_t batchSize = 64;       // Samples per mini-batch
+		std::size_t epochs = 50;          // Upper bound on passes over the training split
+		double validationSplit = 0.1;     // Fraction held out for early stopping (0 disables)
+		std::size_t patience = 5;         // Epochs without validation improvement before stopping
+		unsigned seed = 42;               // Seed for the train/validation split
+	};
+
 	/**
 	 * @brief Neural Network classifier implementation using mlpack
 	 * Implements a feed-forward neural network with two hidden layers
 	 */
 	struct NeuralNet : BaseEstimator
 	{
+		/**
+		 * @brief Backend used by predict()
+		 */
+		enum class InferenceMode
+		{
+			MLPACK,     // mlpack FFN::Predict
+			FUSED,      // exported weights, fused float32 forward pass
+			FUSED_INT8  // exported weights, int8-quantised forward pass
+		};
+
+		/**
+		 * @brief How closely the fused pass follows mlpack on the same inputs
+		 */
+		struct FusedAgreement
+		{
+			double argmaxAgreement = 1.0;  // Fraction of samples with the same predicted class
+			double maxProbDiff = 0.0;      // Largest absolute difference of any class probability
+		};
+
 		/**
 		 * @brief Constructs Neural Network classifier
 		 * @param hiddenUnits1 Number of units in the first hidden layer
 		 * @param hiddenUnits2 Number of units in the second hidden layer
 		 * @param nClasses Number of output classes
+		 * @param config Optimizer, batching and early stopping settings
 		 */
 		NeuralNet(std::size_t hiddenUnits1 = 64, std::size_t hiddenUnits2 = 32, 
-				std::size_t nClasses = 2);
+				std::size_t nClasses = 2, NeuralNetConfig config = NeuralNetConfig());
 
 		/**
 		 * @brief Trains the Neural Network model
@@ -342,8 +382,50 @@ namespace harmony
 		 */
 		bool load(const std::string &directory) override;
 
+		/**
+		 * @brief Selects the backend used for prediction
+		 * @param mode Inference backend (default: FUSED)
+		 */
+		void setInferenceMode(InferenceMode mode) { inferenceMode_ = mode; }
+
+		/**
+		 * @brief Returns the backend selected for prediction
+		 */
+		InferenceMode inferenceMode() const { return inferenceMode_; }
+
+		/**
+		 * @brief Parses "mlpack", "fused" or "int8"
+		 * @throws std::invalid_argument for unknown names
+		 */
+		static InferenceMode inferenceModeFromString(const std::string &name);
+
+		/**
+		 * @brief Inverse of inferenceModeFromString()
+		 */
+		static std::string inferenceModeName(InferenceMode mode);
+
+		/**
+		 * @brief Compares the selected fused backend against mlpack's forward pass
+		 * @param X Data to compare on (n_samples x n_features)
+		 * @return Argmax agreement and largest probability difference
+		 */
+		FusedAgreement checkFusedAgreement(const MatrixXd &X);
+
 	private:
+		/**
+		 * @brief Copies the trained FFN parameters into the fused inference kernel
+		 */
+		void exportFusedWeights();
+
+		/**
+		 * @brief Log-probabilities from mlpack's forward pass (n_samples x n_classes)
+		 */
+		MatrixXd mlpackLogProbs(const MatrixXd &X);
+
 		mlpack::FFN<mlpack::NegativeLogLikelihood, mlpack::HeInitialization> model_;
+		FusedMLP fused_;
+		InferenceMode inferenceMode_ = InferenceMode::FUSED;
+		NeuralNetConfig config_;
 		std::size_t hiddenUnits1_;
 		std::size_t hiddenUnits2_;
 		std::size_t nClasses_;
@@ -0,0 +1,224 @@
+#include "fused_mlp.hpp"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <omp.h>
+
+namespace harmony
+{
+    void FusedMLP::addLayer(const Eigen::MatrixXf &weights, const Eigen::VectorXf &bias)
+    {
+        if (weights.rows() != bias.size())
+            throw std::invalid_argument("FusedMLP: bias size does not match layer outputs");
+        if (!layers_.empty() && layers_.back().weightsT.cols() != weights.cols())
+            throw std::invalid_argument("FusedMLP: layer inputs do not match previous layer outputs");
+
+        Layer layer;
+        layer.weightsT = weights.transpose();
+        layer.bias = bias.transpose();
+        layer.weights = weights;
+
+        // Int8 weights need the activation scales, so they are built by calibrate()
+        layers_.push_back(std::move(layer));
+    }
+
+    void FusedMLP::quantise(Layer &layer, std::vector<float> actScales)
+    {
+        // Input column k is quantised as a_k ~= q_k * s_k; folding s_k into the weights keeps
+        // the dot product a single int32 sum, then each output unit gets its own weight
+        // scale: w_ok * s_k ~= q * scale_o with q in [-127, 127]
+        const Eigen::Index nOut = layer.weights.rows(), nIn = layer.weights.cols();
+        layer.qWeights.resize(nOut * nIn);
+        layer.qScales.resize(nOut);
+        for (Eigen::Index o = 0; o < nOut; ++o)
+        {
+            float maxAbs = 0.0f;
+            for (Eigen::Index k = 0; k < nIn; ++k)
+                maxAbs = std::max(maxAbs, std::abs(layer.weights(o, k) * actScales[k]));
+            const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+            layer.qScales[o] = scale;
+            for (Eigen::Index k = 0; k < nIn; ++k)
+                layer.qWeights[o * nIn + k] = static_cast<int8_t>(std::lround(layer.weights(o, k) * actScales[k] / scale));
+        }
+
+        layer.invActScales.resize(nIn);
+        for (Eigen::Index k = 0; k < nIn; ++k)
+            layer.invActScales[k] = 1.0f / actScales[k];
+        layer.actScales = std::move(actScales);
+    }
+
+    void FusedMLP::calibrate(const MatrixXd &X)
+    {
+        if (layers_.empty())
+            throw std::runtime_error("FusedMLP: no weights exported");
+        if (X.cols() != layers_.front().weightsT.rows())
+            throw std::invalid_argument("FusedMLP: calibration data has " + std::to_string(X.cols()) +
+                                        " features, expected " + std::to_string(layers_.front().weightsT.rows()));
+
+        std::vector<Eigen::RowVectorXf> range(layers_.size());
+        for (size_t l = 0; l < layers_.size(); ++l)
+            range[l] = Eigen::RowVectorXf::Zero(layers_[l].weightsT.rows());
+
+        const Eigen::Index n = X.rows();
+        const Eigen::Index nBlocks = (n + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+        #pragma omp parallel
+        {
+            MatrixXfRM a, b;
+            std::vector<int8_t> qRow;
+            std::vector<Eigen::RowVectorXf> local = range;
+
+            #pragma omp for schedule(static)
+            for (Eigen::Index blk = 0; blk < nBlocks; ++blk)
+            {
+                const Eigen::Index start = blk * BLOCK_ROWS;
+                const Eigen::Index rows = std::min<Eigen::Index>(BLOCK_ROWS, n - start);
+                forwardBlock(X, start, rows, a, b, qRow, Precision::FLOAT32, &local);
+            }
+
+            #pragma omp critical
+            for (size_t l = 0; l < range.size(); ++l)
+                range[l] = range[l].cwiseMax(local[l]);
+        }
+
+        for (size_t l = 0; l < layers_.size(); ++l)
+        {
+            std::vector<float> scales(range[l].size());
+            for (Eigen::Index k = 0; k < range[l].size(); ++k)
+                scales[k] = range[l][k] > 0.0f ? range[l][k] / 127.0f : 1.0f;
+            quantise(layers_[l], std::move(scales));
+        }
+    }
+
+    std::vector<std::vector<float>> FusedMLP::activationScales() const
+    {
+        std::vector<std::vector<float>> scales;
+        for (const Layer &layer : layers_)
+            scales.push_back(layer.actScales);
+        return scales;
+    }
+
+    void FusedMLP::setActivationScales(const std::vector<std::vector<float>> &scales)
+    {
+        if (scales.size() != layers_.size())
+            throw std::invalid_argument("FusedMLP: expected activation scales for " + std::to_string(layers_.size()) + " layers");
+        for (size_t l = 0; l < layers_.size(); ++l)
+        {
+            if (static_cast<Eigen::Index>(scales[l].size()) != layers_[l].weightsT.rows())
+                throw std::invalid_argument("FusedMLP: activation scales of layer " + std::to_string(l + 1) + " do not match its inputs");
+            quantise(layers_[l], scales[l]);
+        }
+    }
+
+    void FusedMLP::clear()
+    {
+        layers_.clear();
+    }
+
+    void FusedMLP::forwardBlock(const MatrixXd &X, Eigen::Index start, Eigen::Index rows,
+                                MatrixXfRM &a, MatrixXfRM &b, std::vector<int8_t> &qRow,
+                                Precision precision, std::vector<Eigen::RowVectorXf> *inputRange) const
+    {
+        a = X.middleRows(start, rows).cast<float>();
+
+        for (size_t l = 0; l < layers_.size(); ++l)
+        {
+            const Layer &layer = layers_[l];
+            const Eigen::Index nIn = layer.weightsT.rows();
+            const Eigen::Index nOut = layer.weightsT.cols();
+
+            if (inputRange)
+                (*inputRange)[l] = (*inputRange)[l].cwiseMax(a.cwiseAbs().colwise().maxCoeff());
+
+            if (precision == Precision::INT8)
+            {
+                b.resize(rows, nOut);
+                qRow.resize(nIn);
+                for (Eigen::Index r = 0; r < rows; ++r)
+                {
+                    // Calibrated per-column scales; values beyond the calibration range saturate
+                    const float *in = a.row(r).data();
+                    for (Eigen::Index k = 0; k < nIn; ++k)
+                        qRow[k] = static_cast<int8_t>(std::clamp(std::lrint(in[k] * layer.invActScales[k]), -127L, 127L));
+
+                    float *out = b.row(r).data();
+                    for (Eigen::Index o = 0; o < nOut; ++o)
+                    {
+                        const int8_t *w = layer.qWeights.data() + o * nIn;
+                        int32_t acc = 0;
+                        #pragma omp simd reduction(+ : acc)
+                        for (Eigen::Index k = 0; k < nIn; ++k)
+                            acc += static_cast<int32_t>(qRow[k]) * static_cast<int32_t>(w[k]);
+                        out[o] = static_cast<float>(acc) * layer.qScales[o] + layer.bias[o];
+                    }
+                }
+            }
+            else
+            {
+                b.noalias() = a * layer.weightsT;
+                b.rowwise() += layer.bias;
+            }
+
+            // ReLU on hidden layers only; the last layer feeds the log-softmax
+            if (l + 1 < layers_.size())
+                b = b.cwiseMax(0.0f);
+
+            a.swap(b);
+        }
+
+        // Numerically stable log-softmax per row
+        for (Eigen::Index r = 0; r < rows; ++r)
+        {
+            auto row = a.row(r);
+            const float maxVal = row.maxCoeff();
+            const float logSum = std::log((row.array() - maxVal).exp().sum()) + maxVal;
+            row.array() -= logSum;
+        }
+    }
+
+    void FusedMLP::forward(const MatrixXd &X, MatrixXfRM &logProbs, Precision precision) const
+    {
+        if (layers_.empty())
+            throw std::runtime_error("FusedMLP: no weights exported");
+        if (X.cols() != layers_.front().weightsT.rows())
+            throw std::invalid_argument("FusedMLP: input has " + std::to_string(X.cols()) +
+                                        " features, expected " + std::to_string(layers_.front().weightsT.rows()));
+        if (precision == Precision::INT8 && !calibrated())
+            throw std::runtime_error("FusedMLP: int8 inference needs calibrate() or saved activation scales");
+
+        const Eigen::Index n = X.rows();
+        const Eigen::Index nBlocks = (n + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        logProbs.resize(n, layers_.back().weightsT.cols());
+
+        #pragma omp parallel
+        {
+            // Per-thread scratch, reused across all blocks handled by the thread
+            MatrixXfRM a, b;
+            std::vector<int8_t> qRow;
+
+            #pragma omp for schedule(static)
+            for (Eigen::Index blk = 0; blk < nBlocks; ++blk)
+            {
+                const Eigen::Index start = blk * BLOCK_ROWS;
+                const Eigen::Index rows = std::min<Eigen::Index>(BLOCK_ROWS, n - start);
+                forwardBlock(X, start, rows, a, b, qRow, precision);
+                logProbs.middleRows(start, rows) = a;
+            }
+        }
+    }
+
+    void FusedMLP::predict(const MatrixXd &X, VectorXi &y_pred, Precision precision) const
+    {
+        MatrixXfRM logProbs;
+        forward(X, logProbs, precision);
+
+        y_pred.resize(X.rows());
+        for (Eigen::Index i = 0; i < logProbs.rows(); ++i)
+        {
+            Eigen::Index maxIndex;
+            logProbs.row(i).maxCoeff(&maxIndex);
+            y_pred(i) = static_cast<int>(maxIndex);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <eigen3/Eigen/Dense>
+
+using Eigen::MatrixXd;
+using Eigen::VectorXi;
+
+namespace harmony
+{
+
+	/**
+	 * @brief Inference-only multilayer perceptron with a fused forward pass
+	 * Holds a copy of the trained weights of a Linear/ReLU stack ending in
+	 * LogSoftMax and evaluates it over large row blocks in parallel.
+	 * Every block runs GEMM + bias + ReLU for each layer and the final
+	 * log-softmax while the (small) weight matrices stay cache resident.
+	 */
+	class FusedMLP
+	{
+	public:
+		using MatrixXfRM = Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+		enum class Precision
+		{
+			FLOAT32, // float weights and activations
+			INT8     // int8 weights (per output unit) and activations (per input column, calibrated), int32 accumulation
+		};
+
+		/// Number of samples processed by one thread at a time
+		static constexpr int BLOCK_ROWS = 256;
+
+		/**
+		 * @brief Appends a dense layer; every layer but the last is followed by ReLU
+		 * @param weights Weight matrix (n_outputs x n_inputs)
+		 * @param bias Bias vector (n_outputs)
+		 */
+		void addLayer(const Eigen::MatrixXf &weights, const Eigen::VectorXf &bias);
+
+		/**
+		 * @brief Removes all layers
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns true if no weights were exported yet
+		 */
+		bool empty() const { return layers_.empty(); }
+
+		/**
+		 * @brief Derives the int8 activation scales from representative inputs
+		 * Runs the float32 pass over X and takes, for every layer input column,
+		 * the largest magnitude seen as the top of its int8 range
+		 * @param X Calibration data (n_samples x n_features), usually the training set
+		 */
+		void calibrate(const MatrixXd &X);
+
+		/**
+		 * @brief Returns true once int8 inference has activation scales
+		 */
+		bool calibrated() const { return !layers_.empty() && !layers_.front().actScales.empty(); }
+
+		/**
+		 * @brief Per-layer, per-input-column activation scales (empty if not calibrated)
+		 */
+		std::vector<std::vector<float>> activationScales() const;
+
+		/**
+		 * @brief Restores activation scales saved from activationScales()
+		 * @param scales One vector per layer, sized to the layer's inputs
+		 */
+		void setActivationScales(const std::vector<std::vector<float>> &scales);
+
+		/**
+		 * @brief Computes log-probabilities for every sample
+		 * @param X Input data (n_samples x n_features)
+		 * @param logProbs Output log-probabilities (n_samples x n_classes)
+		 * @param precision Arithmetic of every dense layer, the output layer included;
+		 * the log-softmax is always computed in float
+		 */
+		void forward(const MatrixXd &X, MatrixXfRM &logProbs, Precision precision = Precision::FLOAT32) const;
+
+		/**
+		 * @brief Predicts the most likely class of every sample
+		 * @param X Input data (n_samples x n_features)
+		 * @param y_pred Output predicted labels (n_samples)
+		 * @param precision Arithmetic of every dense layer, the output layer included;
+		 * the log-softmax is always computed in float
+		 */
+		void predict(const MatrixXd &X, VectorXi &y_pred, Precision precision = Precision::FLOAT32) const;
+
+	private:
+		struct Layer
+		{
+			MatrixXfRM weightsT;               // n_inputs x n_outputs, so a block is X * W^T
+			Eigen::RowVectorXf bias;           // n_outputs
+			Eigen::MatrixXf weights;           // n_outputs x n_inputs, kept for re-quantisation
+			std::vector<float> actScales;      // one scale per input column, set by calibration
+			std::vector<float> invActScales;   // reciprocals of actScales
+			std::vector<int8_t> qWeights;      // n_outputs x n_inputs, row-major, input scales folded in
+			std::vector<float> qScales;        // one scale per output unit
+		};
+
+		std::vector<Layer> layers_;
+
+		static void quantise(Layer &layer, std::vector<float> actScales);
+
+		void forwardBlock(const MatrixXd &X, Eigen::Index start, Eigen::Index rows,
+						  MatrixXfRM &a, MatrixXfRM &b, std::vector<int8_t> &qRow,
+						  Precision precision, std::vector<Eigen::RowVectorXf> *inputRange = nullptr) const;
+	};
+
+}
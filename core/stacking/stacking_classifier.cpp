@@ -18,10 +18,29 @@ StackingClassifier::StackingClassifier(
     L_ = bases_.size();
 }
 
-void StackingClassifier::fit(const MatrixXd& X, const VectorXi& y)
+void StackingClassifier::addTransformer(std::unique_ptr<BaseTransformer> transformer)
 {
-    const int N = X.rows();
-    const int D = X.cols();
+    transformers_.push_back(std::move(transformer));
+}
+
+void StackingClassifier::applyTransformers(MatrixXd& X) const
+{
+    for (const auto& transformer : transformers_)
+        transformer->transform(X);
+}
+
+void StackingClassifier::fitTransformers(MatrixXd& X, const VectorXi& y)
+{
+    // Each stage is fitted on the output of the previous one
+    for (auto& transformer : transformers_) {
+        transformer->fit(X, y);
+        transformer->transform(X);
+    }
+}
+
+void StackingClassifier::fit(const MatrixXd& Xraw, const VectorXi& y)
+{
+    const int N = Xraw.rows();
     const int L = L_;
 
     // Precompute the folds
@@ -29,41 +48,43 @@ void StackingClassifier::fit(const MatrixXd& X, const VectorXi& y)
     std::iota(idx.begin(), idx.end(), 0);
     std::shuffle(idx.begin(), idx.end(), rng_);
     std::vector<std::vector<int>> fold_indices(K_);
-    std::vector<int> fold_of(N);
     for (int i = 0; i < N; ++i)
         fold_indices[idx[i] % K_].push_back(i);
 
     // Meta‐features matrix Z (N × L)
     MatrixXd Z = MatrixXd::Zero(N, L);
 
-    // Parallelize the training of base learners
-    #pragma omp parallel for
-    for (int l = 0; l < L; ++l) {
-        for (int k = 0; k < K_; ++k) {
-            const auto& test_idx = fold_indices[k];
-            std::vector<int> train_idx;
-            for (int k_inner = 0; k_inner < K_; ++k_inner) {
-                if (k_inner != k) {
-                    train_idx.insert(train_idx.end(),
-                        fold_indices[k_inner].begin(), fold_indices[k_inner].end());
-                }
+    for (int k = 0; k < K_; ++k) {
+        const auto& test_idx = fold_indices[k];
+        std::vector<int> train_idx;
+        for (int k_inner = 0; k_inner < K_; ++k_inner) {
+            if (k_inner != k) {
+                train_idx.insert(train_idx.end(),
+                    fold_indices[k_inner].begin(), fold_indices[k_inner].end());
             }
+        }
+
+        MatrixXd Xtr(train_idx.size(), Xraw.cols());
+        VectorXi ytr(train_idx.size());
+        for (size_t i = 0; i < train_idx.size(); ++i) {
+            Xtr.row(i) = Xraw.row(train_idx[i]);
+            ytr(i) = y(train_idx[i]);
+        }
+        MatrixXd Xte(test_idx.size(), Xraw.cols());
+        for (size_t i = 0; i < test_idx.size(); ++i)
+            Xte.row(i) = Xraw.row(test_idx[i]);
 
-            // Train base model l on train_idx
+        // Stages are refitted on the training part of every fold, so the out-of-fold
+        // predictions never come from a scaling or projection that saw the held-out labels
+        fitTransformers(Xtr, ytr);
+        applyTransformers(Xte);
+
+        // Parallelize the training of base learners
+        #pragma omp parallel for
+        for (int l = 0; l < L; ++l) {
             std::cout << "Training base model " << l + 1 << " on fold " << k + 1 << std::endl;
-            MatrixXd Xtr(train_idx.size(), D);
-            VectorXi ytr(train_idx.size());
-            for (size_t i = 0; i < train_idx.size(); ++i) {
-                Xtr.row(i) = X.row(train_idx[i]);
-                ytr(i) = y(train_idx[i]);
-            }
             bases_[l]->train(Xtr, ytr);
 
-            // Predict on test_idx
-            MatrixXd Xte(test_idx.size(), D);
-            for (size_t i = 0; i < test_idx.size(); ++i)
-                Xte.row(i) = X.row(test_idx[i]);
-
             VectorXi ypred(test_idx.size());
             bases_[l]->predict(Xte, ypred);
 
@@ -75,15 +96,23 @@ void StackingClassifier::fit(const MatrixXd& X, const VectorXi& y)
 
     // 4) fit meta-learner on Z and y
     meta_->train(Z, y);
-    // 5) Re‐train each base on FULL (X,y)
+    // 5) Refit the stages and re‐train each base on FULL (X,y)
+    MatrixXd X = Xraw;
+    fitTransformers(X, y);
     for (int l = 0; l < L; ++l)
         bases_[l]->train(X, y);
     fitted_ = true;
 }
 
-void StackingClassifier::predict(const MatrixXd& X, VectorXi& out) const
+void StackingClassifier::predict(const MatrixXd& Xraw, VectorXi& out) const
 {
 	assert(fitted_);
+	MatrixXd Xt;
+	if (!transformers_.empty()) {
+		Xt = Xraw;
+		applyTransformers(Xt);
+	}
+	const MatrixXd& X = transformers_.empty() ? Xraw : Xt;
 	const int M = X.rows();
 	// build meta‐features Ztest (M × L)
 	MatrixXd Ztest(M, L_);
@@ -113,12 +142,18 @@ bool StackingClassifier::saveModels(const std::string &directory) const {
     
     // Save meta model (likely a Logistic Regression model using MLpack)
     success &= meta_->save(directory);
+
+    // Save preprocessing stages
+    for (const auto& transformer : transformers_) {
+        success &= transformer->save(directory);
+    }
     
     // Save configuration
     std::ofstream config(directory + "/config.txt");
     if (config.is_open()) {
         config << "num_base_models=" << L_ << std::endl;
         config << "num_folds=" << K_ << std::endl;
+        config << "num_transformers=" << transformers_.size() << std::endl;
         config << "fitted=" << (fitted_ ? "true" : "false") << std::endl;
         config.close();
     } else {
@@ -136,6 +171,7 @@ bool StackingClassifier::loadModels(const std::string &directory) {
     
     // Load configuration
     std::ifstream config(directory + "/config.txt");
+    size_t numTransformers = 0;
     if (config.is_open()) {
         std::string line;
         while (std::getline(config, line)) {
@@ -143,6 +179,8 @@ bool StackingClassifier::loadModels(const std::string &directory) {
                 L_ = std::stoi(line.substr(16));
             } else if (line.find("num_folds=") == 0) {
                 K_ = std::stoi(line.substr(10));
+            } else if (line.find("num_transformers=") == 0) {
+                numTransformers = std::stoul(line.substr(17));
             } else if (line.find("fitted=") == 0) {
                 fitted_ = (line.substr(7) == "true");
             }
@@ -152,6 +190,18 @@ bool StackingClassifier::loadModels(const std::string &directory) {
         std::cerr << "Failed to open config file" << std::endl;
         return false;
     }
+
+    if (numTransformers != transformers_.size()) {
+        std::cerr << "Model was saved with " << numTransformers << " preprocessing stages but "
+                  << transformers_.size() << " were configured" << std::endl;
+        return false;
+    }
+    for (auto& transformer : transformers_) {
+        if (!transformer->load(directory)) {
+            std::cerr << "Failed to load preprocessing stage" << std::endl;
+            return false;
+        }
+    }
     
     // Load base models
     for (int i = 0; i < L_; ++i) {
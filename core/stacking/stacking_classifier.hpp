@@ -49,6 +49,43 @@ struct BaseEstimator
 	
 };
 
+/**
+ * @brief Base interface for feature transformation stages
+ * Transformers are fitted on the training data and applied to every input
+ * before it reaches the base estimators
+ */
+struct BaseTransformer
+{
+	virtual ~BaseTransformer() = default;
+
+	/**
+     * @brief Learns the transformation parameters
+     * @param X Training data (n_samples x n_features)
+     * @param y Target labels (n_samples), ignored by unsupervised stages
+     */
+	virtual void fit(const MatrixXd &X, const VectorXi &y) = 0;
+
+	/**
+     * @brief Applies the transformation in place
+     * @param X Data to transform (n_samples x n_features), may change its number of columns
+     */
+	virtual void transform(MatrixXd &X) const = 0;
+
+	/**
+     * @brief Saves the fitted parameters
+     * @param directory Directory where to save the stage
+     * @return true if successful, false otherwise
+     */
+	virtual bool save(const std::string &directory) const = 0;
+
+	/**
+     * @brief Loads the fitted parameters
+     * @param directory Directory from where to load the stage
+     * @return true if successful, false otherwise
+     */
+	virtual bool load(const std::string &directory) = 0;
+};
+
 /**
  * @brief Stacking ensemble classifier
  * Combines multiple base models' predictions using a meta-model
@@ -57,10 +94,24 @@ class StackingClassifier
 {
 	std::vector<std::unique_ptr<BaseEstimator>> bases_;
 	std::unique_ptr<BaseEstimator> meta_;
+	std::vector<std::unique_ptr<BaseTransformer>> transformers_;
 	int K_, L_;
 	bool fitted_ = false;
 	std::mt19937 rng_;
 
+	/**
+	 * @brief Runs X through the transformer stages
+	 * @param X Input data, transformed in place
+	 */
+	void applyTransformers(MatrixXd &X) const;
+
+	/**
+	 * @brief Fits the transformer stages in order, each on the output of the previous one
+	 * @param X Training data, transformed in place
+	 * @param y Target labels
+	 */
+	void fitTransformers(MatrixXd &X, const VectorXi &y);
+
 public:
 	/**
      * @brief Constructs a stacking classifier
@@ -74,6 +125,14 @@ public:
 					   int n_folds = 5,
 					   unsigned seed = 1234);
 
+	/**
+	 * @brief Appends a preprocessing stage applied before the base models
+	 * Stages run in insertion order, are refitted per fold inside fit() and on the full
+	 * training set for the final base models, and persisted by saveModels()
+	 * @param transformer Transformer stage
+	 */
+	void addTransformer(std::unique_ptr<BaseTransformer> transformer);
+
 	/**
    	 * @brief Trains the stacking classifier
    	 * Uses out-of-fold predictions from base models to train meta-model
@@ -0,0 +1,349 @@
+#include "transformers.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <random>
+#include <map>
+#include <omp.h>
+
+namespace harmony
+{
+    namespace
+    {
+        void writeMatrix(std::ostream &out, const MatrixXd &m)
+        {
+            const int64_t rows = m.rows(), cols = m.cols();
+            out.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+            out.write(reinterpret_cast<const char *>(&cols), sizeof(cols));
+            out.write(reinterpret_cast<const char *>(m.data()), sizeof(double) * m.size());
+        }
+
+        void readMatrix(std::istream &in, MatrixXd &m)
+        {
+            int64_t rows = 0, cols = 0;
+            in.read(reinterpret_cast<char *>(&rows), sizeof(rows));
+            in.read(reinterpret_cast<char *>(&cols), sizeof(cols));
+            if (!in || rows < 0 || cols < 0)
+                throw std::runtime_error("corrupt matrix header");
+            m.resize(rows, cols);
+            in.read(reinterpret_cast<char *>(m.data()), sizeof(double) * m.size());
+            if (!in)
+                throw std::runtime_error("truncated matrix data");
+        }
+
+        /// Shared by the projection stages: stores the training mean and the basis
+        bool saveProjection(const std::string &filepath, const Eigen::RowVectorXd &mean, const MatrixXd &components)
+        {
+            std::ofstream ofs(filepath, std::ios::binary);
+            writeMatrix(ofs, mean);
+            writeMatrix(ofs, components);
+            return static_cast<bool>(ofs);
+        }
+
+        void loadProjection(const std::string &filepath, Eigen::RowVectorXd &mean, MatrixXd &components)
+        {
+            std::ifstream ifs(filepath, std::ios::binary);
+            if (!ifs.is_open())
+                throw std::runtime_error("cannot open " + filepath);
+            MatrixXd m;
+            readMatrix(ifs, m);
+            readMatrix(ifs, components);
+            if (m.rows() != 1 || m.cols() != components.rows())
+                throw std::runtime_error("projection mean does not match basis");
+            mean = m;
+        }
+
+        void project(MatrixXd &X, const Eigen::RowVectorXd &mean, const MatrixXd &components)
+        {
+            if (X.cols() != components.rows())
+                throw std::invalid_argument("projection expects " + std::to_string(components.rows()) +
+                                            " features, got " + std::to_string(X.cols()));
+            X.rowwise() -= mean;
+            MatrixXd projected = X * components;
+            X.swap(projected);
+        }
+
+        /// Linear-interpolated quantile of an unsorted sample (reorders the sample)
+        double quantile(std::vector<double> &values, double q)
+        {
+            const double pos = q * (values.size() - 1);
+            const size_t lo = static_cast<size_t>(pos);
+            std::nth_element(values.begin(), values.begin() + lo, values.end());
+            const double vLo = values[lo];
+            if (lo + 1 >= values.size())
+                return vLo;
+            const double vHi = *std::min_element(values.begin() + lo + 1, values.end());
+            return vLo + (pos - lo) * (vHi - vLo);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    //-----------------------------Feature Scaler-------------------------------------------
+    //--------------------------------------------------------------------------------------
+    FeatureScaler::FeatureScaler(Method method)
+        : method_(method)
+    {
+    }
+
+    FeatureScaler::Method FeatureScaler::methodFromString(const std::string &name)
+    {
+        if (name == "zscore")
+            return Method::ZSCORE;
+        if (name == "robust")
+            return Method::ROBUST;
+        throw std::invalid_argument("Unknown scaling method: " + name);
+    }
+
+    void FeatureScaler::fit(const MatrixXd &X, const VectorXi &)
+    {
+        const Eigen::Index n = X.rows(), d = X.cols();
+        center_.resize(d);
+        invScale_.resize(d);
+
+        #pragma omp parallel for
+        for (Eigen::Index j = 0; j < d; ++j)
+        {
+            double center, scale;
+            if (method_ == Method::ROBUST)
+            {
+                std::vector<double> column(X.col(j).data(), X.col(j).data() + n);
+                center = quantile(column, 0.5);
+                scale = quantile(column, 0.75) - quantile(column, 0.25);
+            }
+            else
+            {
+                center = X.col(j).mean();
+                scale = std::sqrt((X.col(j).array() - center).square().sum() / std::max<Eigen::Index>(1, n));
+            }
+
+            // Constant columns are only centered
+            center_(j) = center;
+            invScale_(j) = scale > 1e-12 ? 1.0 / scale : 1.0;
+        }
+    }
+
+    void FeatureScaler::transform(MatrixXd &X) const
+    {
+        if (X.cols() != center_.size())
+            throw std::invalid_argument("FeatureScaler: expected " + std::to_string(center_.size()) +
+                                        " features, got " + std::to_string(X.cols()));
+
+        // Columns are contiguous, so each one is a single fused subtract-multiply sweep
+        #pragma omp parallel for
+        for (Eigen::Index j = 0; j < X.cols(); ++j)
+        {
+            X.col(j) = (X.col(j).array() - center_(j)) * invScale_(j);
+        }
+    }
+
+    bool FeatureScaler::save(const std::string &directory) const
+    {
+        try
+        {
+            std::ofstream ofs(directory + "/FeatureScaler.bin", std::ios::binary);
+            const int32_t method = static_cast<int32_t>(method_);
+            ofs.write(reinterpret_cast<const char *>(&method), sizeof(method));
+            writeMatrix(ofs, center_);
+            writeMatrix(ofs, invScale_);
+            return static_cast<bool>(ofs);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error saving feature scaler: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool FeatureScaler::load(const std::string &directory)
+    {
+        try
+        {
+            std::ifstream ifs(directory + "/FeatureScaler.bin", std::ios::binary);
+            if (!ifs.is_open())
+                throw std::runtime_error("cannot open " + directory + "/FeatureScaler.bin");
+            int32_t method = -1;
+            ifs.read(reinterpret_cast<char *>(&method), sizeof(method));
+            if (!ifs || (method != static_cast<int32_t>(Method::ZSCORE) && method != static_cast<int32_t>(Method::ROBUST)))
+                throw std::runtime_error("unknown scaling method " + std::to_string(method));
+            MatrixXd center, invScale;
+            readMatrix(ifs, center);
+            readMatrix(ifs, invScale);
+            if (center.cols() != 1 || invScale.cols() != 1 || center.rows() != invScale.rows())
+                throw std::runtime_error("scaler center does not match its scales");
+            method_ = static_cast<Method>(method);
+            center_ = center;
+            invScale_ = invScale;
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error loading feature scaler: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    //-----------------------------PCA------------------------------------------------------
+    //--------------------------------------------------------------------------------------
+    PCA::PCA(std::size_t nComponents, std::size_t oversampling, std::size_t powerIterations, unsigned seed)
+        : nComponents_(nComponents), oversampling_(oversampling), powerIterations_(powerIterations), seed_(seed)
+    {
+        if (nComponents_ < 1)
+            throw std::invalid_argument("PCA needs at least one component");
+    }
+
+    void PCA::fit(const MatrixXd &X, const VectorXi &)
+    {
+        const Eigen::Index d = X.cols();
+        const Eigen::Index k = std::min<Eigen::Index>(nComponents_, std::min(d, X.rows()));
+        const Eigen::Index l = std::min<Eigen::Index>(k + oversampling_, std::min(d, X.rows()));
+
+        mean_ = X.colwise().mean();
+        const MatrixXd Xc = X.rowwise() - mean_;
+
+        // Range finder: Q spans (approximately) the top-l left singular subspace
+        std::mt19937 rng(seed_);
+        std::normal_distribution<double> gauss;
+        MatrixXd omega(d, l);
+        for (Eigen::Index i = 0; i < omega.size(); ++i)
+            omega.data()[i] = gauss(rng);
+
+        auto orthonormalize = [](const MatrixXd &A) {
+            Eigen::HouseholderQR<MatrixXd> qr(A);
+            return MatrixXd(qr.householderQ() * MatrixXd::Identity(A.rows(), A.cols()));
+        };
+
+        MatrixXd Q = orthonormalize(Xc * omega);
+        for (std::size_t it = 0; it < powerIterations_; ++it)
+        {
+            MatrixXd Z = orthonormalize(Xc.transpose() * Q);
+            Q = orthonormalize(Xc * Z);
+        }
+
+        // SVD of the small l x d matrix gives the right singular vectors
+        MatrixXd B = Q.transpose() * Xc;
+        Eigen::JacobiSVD<MatrixXd> svd(B, Eigen::ComputeThinV);
+        components_ = svd.matrixV().leftCols(k);
+    }
+
+    void PCA::transform(MatrixXd &X) const
+    {
+        project(X, mean_, components_);
+    }
+
+    bool PCA::save(const std::string &directory) const
+    {
+        try
+        {
+            return saveProjection(directory + "/PCA_projection.bin", mean_, components_);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error saving PCA projection: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool PCA::load(const std::string &directory)
+    {
+        try
+        {
+            loadProjection(directory + "/PCA_projection.bin", mean_, components_);
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error loading PCA projection: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    //-----------------------------Fisher LDA-----------------------------------------------
+    //--------------------------------------------------------------------------------------
+    FisherLDA::FisherLDA(std::size_t nComponents, double shrinkage)
+        : nComponents_(nComponents), shrinkage_(shrinkage)
+    {
+        if (nComponents_ < 1)
+            throw std::invalid_argument("Fisher LDA needs at least one component");
+    }
+
+    void FisherLDA::fit(const MatrixXd &X, const VectorXi &y)
+    {
+        const Eigen::Index d = X.cols();
+        mean_ = X.colwise().mean();
+
+        // Class means and counts
+        std::map<int, std::pair<Eigen::RowVectorXd, Eigen::Index>> classes;
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+        {
+            auto &entry = classes[y(i)];
+            if (entry.second == 0)
+                entry.first = Eigen::RowVectorXd::Zero(d);
+            entry.first += X.row(i);
+            entry.second++;
+        }
+        for (auto &[label, entry] : classes)
+            entry.first /= static_cast<double>(entry.second);
+
+        if (classes.size() < 2)
+            throw std::invalid_argument("Fisher LDA needs at least two classes");
+
+        // Within-class scatter from class-centered data, between-class from the means
+        MatrixXd centered(X.rows(), d);
+        for (Eigen::Index i = 0; i < X.rows(); ++i)
+            centered.row(i) = X.row(i) - classes[y(i)].first;
+        MatrixXd Sw = centered.transpose() * centered;
+
+        MatrixXd Sb = MatrixXd::Zero(d, d);
+        for (const auto &[label, entry] : classes)
+        {
+            const Eigen::RowVectorXd diff = entry.first - mean_;
+            Sb += static_cast<double>(entry.second) * diff.transpose() * diff;
+        }
+
+        // Shrinkage keeps Sw positive definite when features are collinear
+        const double ridge = shrinkage_ * Sw.trace() / d;
+        Sw.diagonal().array() += std::max(ridge, 1e-12);
+
+        Eigen::GeneralizedSelfAdjointEigenSolver<MatrixXd> solver(Sb, Sw);
+        const Eigen::Index k = std::min<Eigen::Index>(nComponents_, std::min<Eigen::Index>(classes.size() - 1, d));
+
+        // Eigenvalues come in ascending order; keep the most discriminative directions
+        components_ = solver.eigenvectors().rightCols(k).rowwise().reverse();
+    }
+
+    void FisherLDA::transform(MatrixXd &X) const
+    {
+        project(X, mean_, components_);
+    }
+
+    bool FisherLDA::save(const std::string &directory) const
+    {
+        try
+        {
+            return saveProjection(directory + "/FisherLDA_projection.bin", mean_, components_);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error saving Fisher LDA projection: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool FisherLDA::load(const std::string &directory)
+    {
+        try
+        {
+            loadProjection(directory + "/FisherLDA_projection.bin", mean_, components_);
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error loading Fisher LDA projection: " << e.what() << std::endl;
+            return false;
+        }
+    }
+}
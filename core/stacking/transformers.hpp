@@ -0,0 +1,174 @@
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Dense>
+#include "stacking_classifier.hpp"
+
+using Eigen::MatrixXd;
+using Eigen::VectorXi;
+
+namespace harmony
+{
+
+	/**
+	 * @brief Per-feature standardisation stage
+	 * Maps every column to (x - center) / scale, using mean/std (z-score)
+	 * or median/IQR (robust, insensitive to outlier clips)
+	 */
+	struct FeatureScaler : BaseTransformer
+	{
+		enum class Method
+		{
+			ZSCORE,
+			ROBUST
+		};
+
+		/**
+		 * @brief Constructs a scaler
+		 * @param method Statistic used for centering and scaling
+		 */
+		explicit FeatureScaler(Method method = Method::ZSCORE);
+
+		/**
+		 * @brief Parses "zscore" or "robust"
+		 * @throws std::invalid_argument for unknown names
+		 */
+		static Method methodFromString(const std::string &name);
+
+		/**
+		 * @brief Computes the per-column center and scale
+		 * @param X Training data (n_samples x n_features)
+		 * @param y Target labels (unused)
+		 */
+		void fit(const MatrixXd &X, const VectorXi &y) override;
+
+		/**
+		 * @brief Standardises X in a single parallel, vectorised pass over its columns
+		 * @param X Data to scale (n_samples x n_features)
+		 */
+		void transform(MatrixXd &X) const override;
+
+		/**
+		 * @brief Saves the scaler to a file
+		 * @param directory Path where to save the scaler
+		 * @return true if successful, false otherwise
+		 */
+		bool save(const std::string &directory) const override;
+
+		/**
+		 * @brief Loads the scaler from a file
+		 * @param directory Path from where to load the scaler
+		 * @return true if successful, false otherwise
+		 */
+		bool load(const std::string &directory) override;
+
+	private:
+		Method method_;
+		Eigen::VectorXd center_;
+		Eigen::VectorXd invScale_;
+	};
+
+	/**
+	 * @brief Principal component projection computed with a randomised SVD
+	 * Uses a Gaussian range finder with oversampling and power iterations
+	 * (Halko et al.), so fitting costs O(n d k) instead of a full O(n d^2)
+	 * decomposition
+	 */
+	struct PCA : BaseTransformer
+	{
+		/**
+		 * @brief Constructs a PCA stage
+		 * @param nComponents Output dimensionality
+		 * @param oversampling Extra random directions used by the range finder
+		 * @param powerIterations Subspace iterations, sharpen the spectrum for slowly decaying singular values
+		 * @param seed Random seed for the range finder
+		 */
+		PCA(std::size_t nComponents = 16, std::size_t oversampling = 10,
+			std::size_t powerIterations = 2, unsigned seed = 42);
+
+		/**
+		 * @brief Computes the mean and the leading principal directions
+		 * @param X Training data (n_samples x n_features)
+		 * @param y Target labels (unused)
+		 */
+		void fit(const MatrixXd &X, const VectorXi &y) override;
+
+		/**
+		 * @brief Projects X onto the principal directions
+		 * @param X Data to project (n_samples x n_features), becomes (n_samples x nComponents)
+		 */
+		void transform(MatrixXd &X) const override;
+
+		/**
+		 * @brief Saves the projection to a file
+		 * @param directory Path where to save the projection
+		 * @return true if successful, false otherwise
+		 */
+		bool save(const std::string &directory) const override;
+
+		/**
+		 * @brief Loads the projection from a file
+		 * @param directory Path from where to load the projection
+		 * @return true if successful, false otherwise
+		 */
+		bool load(const std::string &directory) override;
+
+	private:
+		std::size_t nComponents_;
+		std::size_t oversampling_;
+		std::size_t powerIterations_;
+		unsigned seed_;
+		Eigen::RowVectorXd mean_;
+		MatrixXd components_; // n_features x nComponents
+	};
+
+	/**
+	 * @brief Fisher linear discriminant projection
+	 * Finds the directions maximising between-class over within-class scatter.
+	 * At most n_classes - 1 directions carry information, so the output is
+	 * capped there.
+	 */
+	struct FisherLDA : BaseTransformer
+	{
+		/**
+		 * @brief Constructs a Fisher LDA stage
+		 * @param nComponents Requested output dimensionality (capped at n_classes - 1)
+		 * @param shrinkage Ridge added to the within-class scatter, relative to its mean eigenvalue
+		 */
+		FisherLDA(std::size_t nComponents = 16, double shrinkage = 1e-3);
+
+		/**
+		 * @brief Solves the generalised eigenproblem Sb w = lambda Sw w
+		 * @param X Training data (n_samples x n_features)
+		 * @param y Target labels (n_samples)
+		 */
+		void fit(const MatrixXd &X, const VectorXi &y) override;
+
+		/**
+		 * @brief Projects X onto the discriminant directions
+		 * @param X Data to project (n_samples x n_features)
+		 */
+		void transform(MatrixXd &X) const override;
+
+		/**
+		 * @brief Saves the projection to a file
+		 * @param directory Path where to save the projection
+		 * @return true if successful, false otherwise
+		 */
+		bool save(const std::string &directory) const override;
+
+		/**
+		 * @brief Loads the projection from a file
+		 * @param directory Path from where to load the projection
+		 * @return true if successful, false otherwise
+		 */
+		bool load(const std::string &directory) override;
+
+	private:
+		std::size_t nComponents_;
+		double shrinkage_;
+		Eigen::RowVectorXd mean_;
+		MatrixXd components_; // n_features x n_outputs
+	};
+
+}
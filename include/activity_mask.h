@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Per-frame speech/non-speech decisions for a signal.
+ *
+ * The signal is split into consecutive, non-overlapping frames of frameSize samples
+ * and active[i] says whether frame i holds speech. validSamples marks where real
+ * audio ends; anything after it (e.g. trimAudio's zero padding) is never active.
+ * An empty mask (frameSize == 0) means "no information": every frame counts as active.
+ */
+struct ActivityMask {
+    int frameSize = 0;
+    std::vector<uint8_t> active;
+    size_t validSamples = 0;
+
+    bool empty() const { return frameSize <= 0; }
+
+    /**
+     * @brief True if any active frame overlaps samples [start, start + length).
+     */
+    bool isActive(size_t start, size_t length) const {
+        if (empty()) return true;
+        if (start >= validSamples) return false;
+        const size_t first = start / frameSize;
+        const size_t last = std::min(active.size(), (start + length + frameSize - 1) / frameSize);
+        for (size_t i = first; i < last; ++i) {
+            if (active[i]) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Follows a truncation or zero-padding of the signal to a new length.
+     */
+    void fitTo(size_t samples) {
+        if (empty()) return;
+        validSamples = std::min(validSamples, samples);
+        active.resize((samples + frameSize - 1) / frameSize, 0);
+    }
+};
@@ -2,6 +2,42 @@
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <bits/stdc++.h>
+#include "activity_mask.h"
+
+/**
+ * @brief Constant-Q chroma from moderate-size FFT frames.
+ *
+ * Each constant-Q bin is a windowed complex exponential whose spectrum is precomputed
+ * once (Brown & Puckette's spectral kernel) and thresholded, so the transform of a
+ * frame is one FFT from the shared StftEngine plus a short sparse product per bin.
+ * Every bin keeps its full constant-Q window: octaves whose window would exceed the
+ * frame are analysed on the signal decimated by 2, 4, ... (one extra FFT per decimation
+ * level), with frames centred on the full-rate ones. Kernels are cached per
+ * configuration and shared across calls and threads.
+ */
+class ChromaEngine {
+public:
+    ChromaEngine(int sampleRate, int frameSize, float minFrequency, int binsPerOctave,
+                 float threshold, const std::string& windowType);
+
+    int getBinsPerOctave() const { return binsPerOctave; }
+
+    /**
+     * @brief Appends one unnormalised chroma vector (binsPerOctave values, constant-Q
+     * magnitudes folded over octaves) per frame; frames follow FrameCutter(startFromZero)
+     * and skip frames the activity mask marks inactive.
+     */
+    void compute(std::span<const float> audio, int hopSize, const ActivityMask* mask,
+                 std::vector<std::vector<float>>& chroma) const;
+
+    struct Kernel;
+
+private:
+    int sampleRate;
+    int frameSize;
+    int binsPerOctave;
+    std::shared_ptr<const Kernel> kernel;
+};
 
 std::vector<float> extractChromaFeatures(
     const std::string& filename,
@@ -15,6 +51,7 @@ std::vector<float> extractChromaFeatures(
     const std::string& windowType,
     essentia::standard::AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<essentia::Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const essentia::Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity = nullptr
 );
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Persistent feature cache keyed by (audio content hash, settings hash).
+ *
+ * Entries live in an append-only file (features.cache) inside the cache directory.
+ * Every record holds the 64-bit FNV-1a hash of the audio file contents, the hash of
+ * the preprocessing + extractor settings and the feature vector. Records written
+ * with other settings are kept in the file but never returned, and a truncated
+ * trailing record (e.g. from a crash) is ignored on load.
+ * lookup() and store() are thread-safe.
+ */
+class FeatureCache {
+public:
+    /**
+     * @brief Opens (or creates) the cache in a directory.
+     *
+     * @param directory Cache directory, created if missing.
+     * @param settingsSignature Preprocessing and extractor settings that produced the features.
+     */
+    FeatureCache(const std::string& directory, const std::string& settingsSignature);
+
+    /**
+     * @brief 64-bit FNV-1a hash of a byte range.
+     */
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+    /**
+     * @brief Hashes the full contents of a file.
+     *
+     * @throws std::runtime_error if the file cannot be read.
+     */
+    static uint64_t hashFile(const std::string& path);
+
+    /**
+     * @brief Looks up the features of an audio file.
+     *
+     * @param contentHash Hash returned by hashFile.
+     * @param features Filled with the cached features on a hit.
+     * @return True on a hit.
+     */
+    bool lookup(uint64_t contentHash, std::vector<float>& features);
+
+    /**
+     * @brief Adds features to the cache and appends them to disk.
+     */
+    void store(uint64_t contentHash, const std::vector<float>& features);
+
+    size_t size() const;
+    size_t hits() const { return hits_.load(); }
+    size_t misses() const { return misses_.load(); }
+
+private:
+    uint64_t settingsHash_;
+    std::unordered_map<uint64_t, std::vector<float>> entries_;
+    std::ofstream journal_;
+    mutable std::mutex mutex_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+
+    void loadJournal(const std::string& path);
+};
@@ -1,12 +1,41 @@
+#include <span>
 #include <vector>
 #include "mfcc.h"
 #include "chroma.h"
 #include "spectral_contrast.h"
 #include "tonnetz.h" 
 #include "mel_spectrogram.h"
+#include "feature_set.h"
 #include <essentia/algorithmfactory.h>
 
 using namespace essentia;
 using namespace standard;
 
-std::vector<float> getFeatureVector(std::string path, std::vector<essentia::Real> inputAudio = std::vector<essentia::Real>());
\ No newline at end of file
+/**
+ * @brief Extracts the feature vector of a file or an in-memory clip.
+ *
+ * Runs the families the feature set selects, in FeatureSet order, so the result lines
+ * up with features.featureNames(). Every extractor reads the same decoded samples
+ * without copying them. Trailing zero padding (see AudioPreprocessor::trimAudio) is excluded
+ * from every extractor. With an activity mask, its validSamples bounds the signal
+ * instead and frames outside detected speech are neither computed nor counted in the
+ * statistics.
+ */
+std::vector<float> getFeatureVector(const FeatureSet& features, std::string path, std::vector<essentia::Real> inputAudio = std::vector<essentia::Real>(), const ActivityMask* activity = nullptr);
+
+/**
+ * @brief getFeatureVector over samples the caller already holds (a reused buffer, a
+ * mapped PCM archive clip), read in place. Returns an empty vector for empty audio.
+ */
+std::vector<float> getFeatureVector(const FeatureSet& features, std::span<const essentia::Real> audio, const ActivityMask* activity = nullptr);
+
+/**
+ * @brief getFeatureVector with the default (MFCC-only) feature set.
+ */
+std::vector<float> getFeatureVector(std::string path, std::vector<essentia::Real> inputAudio = std::vector<essentia::Real>(), const ActivityMask* activity = nullptr);
+
+/**
+ * @brief Compares the native MFCC kernel with Essentia's MFCC on a file or an
+ * in-memory clip, using the feature set's MFCC settings.
+ */
+MfccComparison validateMFCC(const FeatureSet& features, std::string path, std::vector<essentia::Real> inputAudio = std::vector<essentia::Real>());
@@ -0,0 +1,126 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * @brief Which feature families are extracted, and with which parameters.
+ *
+ * A model is trained on one feature layout, so the feature set travels with it as
+ * feature_set.txt in the model directory: extract_features writes it next to the
+ * feature files, stacking copies it into the model directory and inference loads it
+ * from there. getFeatureVector and featureNames() both read the same descriptor, so
+ * the extracted columns and their names cannot drift apart.
+ *
+ * The file holds one "key=value" per line ('#' starts a comment). "families" lists the
+ * enabled families (mfcc, chroma, spectral_contrast, tonnetz, mel_spectrogram) and
+ * "<family>.<parameter>" keys override defaults. Families are always extracted in that
+ * order. "activity" records which frames the columns were computed from. A
+ * default-constructed FeatureSet is the MFCC-only set over every frame.
+ */
+struct FeatureSet {
+    // Bumped when the file format or the meaning of a key changes
+    static const int VERSION = 2;
+    static constexpr const char* FILE_NAME = "feature_set.txt";
+
+    struct Mfcc {
+        bool enabled = true;
+        int frameSize = 400;
+        int hopSize = 160;
+        int bands = 26;
+        int coefficients = 26;
+        float lowFrequency = 0;
+        float highFrequency = 8000;
+        int liftering = 22;
+        int dctType = 2;
+        std::string logType = "dbamp";
+    };
+
+    struct Chroma {
+        bool enabled = false;
+        int frameSize = 4096;
+        int hopSize = 1024;
+        float minFrequency = 55.0f;
+        int binsPerOctave = 36;
+        float threshold = 0.01f;
+        std::string normalizeType = "unit_max";
+        std::string windowType = "hann";
+    };
+
+    struct SpectralContrast {
+        bool enabled = false;
+        int frameSize = 2048;
+        int hopSize = 1024;
+        int bands = 6;
+        float lowFrequency = 20;
+        float highFrequency = 8000;
+        float neighbourRatio = 0.4f;
+        float staticDistribution = 1.0f;
+    };
+
+    // Framing and chroma resolution are fixed by the extractor
+    struct Tonnetz {
+        bool enabled = false;
+    };
+
+    struct MelSpectrogram {
+        bool enabled = false;
+        int frameSize = 2048;
+        int hopSize = 1024;
+        int bands = 40;
+        float lowFrequency = 20;
+        float highFrequency = 8000;
+        std::string warpingFormula = "htkMel";
+        std::string weighting = "linear";
+        std::string normalize = "unit_sum";
+        std::string type = "power";
+    };
+
+    int sampleRate = 16000;
+    // "none": every frame of the clip. "mask": only the frames the preprocessor's voice
+    // activity detector kept (extract_features --preprocess). Inference extracts the same way
+    std::string activity = "none";
+    Mfcc mfcc;
+    Chroma chroma;
+    SpectralContrast spectralContrast;
+    Tonnetz tonnetz;
+    MelSpectrogram melSpectrogram;
+
+    /**
+     * @brief Parses a feature set file.
+     *
+     * @throws std::runtime_error if the file cannot be read, has a newer version,
+     * an unknown key or family, a malformed value, or a parameter an enabled family
+     * cannot be extracted with (non-positive sizes or counts, inverted band edges or
+     * edges above Nyquist); the message names the file and line.
+     */
+    static FeatureSet load(const std::string& path);
+
+    /**
+     * @brief Loads modelDir/feature_set.txt; models saved before feature sets existed
+     * have none and get the default (MFCC-only) set.
+     */
+    static FeatureSet forModel(const std::string& modelDir);
+
+    /**
+     * @brief Writes every family's parameters, enabled or not.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Settings string of the enabled families, used to key feature caches and
+     * to detect feature layouts that do not match.
+     */
+    std::string signature() const;
+
+    /**
+     * @brief Enabled families joined with '+', e.g. "mfcc+chroma".
+     */
+    std::string describe() const;
+
+    /**
+     * @brief Name of every column getFeatureVector produces, in order.
+     */
+    std::vector<std::string> featureNames() const;
+};
@@ -2,13 +2,20 @@
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <bits/stdc++.h>
+#include "activity_mask.h"
 
 using namespace essentia;
 using namespace standard;
 
 void initializeEssentia();
 void shutdownEssentia();
+// Loads audioBuffer; returns nullptr when a WAV was decoded natively (delete on the result stays safe)
 Algorithm* createAudioLoader(const std::string& filename, int sampleRate, std::vector<Real>& audioBuffer);
 Algorithm* createFrameCutter(int frameSize, int hopSize, const std::vector<Real>& audioBuffer, std::vector<Real>& frame);
 Algorithm* createWindowing(const std::vector<Real>& frame, std::vector<Real>& windowedFrame);
+// Narrows audio to drop trailing padding (activity->validSamples, or the run of exact zeros
+// trimAudio appends) and returns the mask frames should be checked against, or nullptr to
+// process every frame. Every extractor calls it before framing, so padding is never framed
+// and frames outside the activity mask are skipped
+const ActivityMask* prepareActiveRegion(std::span<const Real>& audio, const ActivityMask* activity);
 void computeStats(const std::vector<std::vector<Real>>& features, std::vector<Real>& means, std::vector<Real>& stddevs);
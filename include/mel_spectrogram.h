@@ -2,6 +2,7 @@
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <bits/stdc++.h>
+#include "activity_mask.h"
 
 std::vector<float> extractMelSpectrogramFeatures(
     const std::string& filename,
@@ -17,6 +18,7 @@ std::vector<float> extractMelSpectrogramFeatures(
     const std::string& type,
     essentia::standard::AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<essentia::Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const essentia::Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity = nullptr
 );
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <bits/stdc++.h>
+#include "activity_mask.h"
 
 std::vector<float> extractMFCCFeatures(
     const std::string& filename,
@@ -17,6 +18,61 @@ std::vector<float> extractMFCCFeatures(
     const std::string& logType,
     essentia::standard::AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<essentia::Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const essentia::Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity = nullptr
+);
+
+
+/**
+ * @brief Per-frame MFCCs through Essentia's Spectrum and MFCC algorithms.
+ *
+ * The reference implementation for MfccKernel, and the fallback for settings the
+ * kernel does not implement.
+ */
+std::vector<std::vector<essentia::Real>> computeMFCCFramesEssentia(
+    std::span<const essentia::Real> audio,
+    int sampleRate,
+    int frameSize,
+    int hopSize,
+    int numberBands,
+    int numberCoefficients,
+    float lowFrequencyBound,
+    float highFrequencyBound,
+    int liftering,
+    int dctType,
+    const std::string& logType,
+    essentia::standard::AlgorithmFactory& factory,
+    const ActivityMask* mask = nullptr
+);
+
+/**
+ * @brief Frame-by-frame difference between MfccKernel and the Essentia reference.
+ */
+struct MfccComparison {
+    size_t nativeFrames = 0;
+    size_t referenceFrames = 0;
+    float maxAbsError = 0.0f;
+    float meanAbsError = 0.0f;
+
+    bool matches(float tolerance) const {
+        return nativeFrames == referenceFrames && maxAbsError <= tolerance;
+    }
+};
+
+/**
+ * @brief Runs both MFCC implementations (DCT-II) over the same clip and compares them.
+ */
+MfccComparison compareMFCCImplementations(
+    std::span<const essentia::Real> audio,
+    int sampleRate,
+    int frameSize,
+    int hopSize,
+    int numberBands,
+    int numberCoefficients,
+    float lowFrequencyBound,
+    float highFrequencyBound,
+    int liftering,
+    const std::string& logType,
+    essentia::standard::AlgorithmFactory& factory
 );
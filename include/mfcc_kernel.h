@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <span>
+#include <vector>
+#include "activity_mask.h"
+
+/**
+ * @brief Native MFCC kernel reproducing Essentia's FrameCutter > Windowing(hann) >
+ * Spectrum > MFCC chain (htkMel, warping weights, unit_sum filters, power bands, DCT-II).
+ *
+ * Frames are processed in blocks: every frame of a block is windowed and transformed,
+ * the power spectra are reduced by the sparse triangular mel weights (each filter only
+ * stores its non-zero bin range), the band energies are log-compressed with a SIMD log,
+ * and the DCT (with liftering folded into its rows) runs as one small matrix product
+ * over the whole block.
+ */
+class MfccKernel {
+public:
+    MfccKernel(int sampleRate, int frameSize, int numberBands, int numberCoefficients,
+               float lowFrequencyBound, float highFrequencyBound, int liftering,
+               const std::string& logType);
+
+    /**
+     * @brief True if the kernel implements this DCT/log combination; other settings
+     * have to go through Essentia.
+     */
+    static bool supports(int dctType, const std::string& logType);
+
+    /**
+     * @brief Appends the MFCCs of every frame of audio to mfccs.
+     *
+     * Frames follow FrameCutter(startFromZero) through StftEngine::frameStarts, including
+     * the final zero-padded frame that reaches the end of the signal. Frames outside the
+     * activity mask are skipped.
+     */
+    void compute(std::span<const float> audio, int hopSize, const ActivityMask* mask,
+                 std::vector<std::vector<float>>& mfccs) const;
+
+    int getFrameSize() const { return frameSize; }
+    int getNumberCoefficients() const { return numberCoefficients; }
+
+private:
+    struct MelFilter {
+        int firstBin;
+        std::vector<float> weights;
+    };
+
+    int frameSize;
+    int bins;
+    int numberBands;
+    int numberCoefficients;
+    float logScale;   // 20/ln10 (dbamp), 10/ln10 (dbpow) or 1 (log)
+
+    std::vector<float> window;
+    std::vector<MelFilter> filters;
+    std::vector<float> dct;   // numberCoefficients x numberBands, liftering applied
+};
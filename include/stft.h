@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "activity_mask.h"
+
+/**
+ * @brief Batched short-time Fourier transform on process-wide FFTW plans.
+ *
+ * Frames are transformed BLOCK_FRAMES at a time by one plan of FFTW's advanced
+ * ("many") interface, so twiddle factors are loaded once per block and the codelets
+ * run long vector loops. Plans are created once per frame size and shared by every
+ * thread; each thread transforms its own block buffers through FFTW's new-array
+ * execute, which is thread-safe. Planning goes through harmony::FftwPlanner, so FFTW
+ * wisdom is reused across runs.
+ *
+ * Typical use: loadFrame() up to BLOCK_FRAMES rows, execute(), then read each row with
+ * powerSpectrum() or magnitudeSpectrum().
+ */
+class StftEngine {
+public:
+    static const int BLOCK_FRAMES = 32;
+
+    explicit StftEngine(int frameSize);
+
+    int getFrameSize() const { return frameSize; }
+    int getBins() const { return frameSize / 2 + 1; }
+
+    /**
+     * @brief Frame offsets produced by Essentia's FrameCutter(startFromZero,
+     * lastFrameToEndOfFile=false): one every hopSize samples up to and including the
+     * first frame that reaches the end of the signal, which loadFrame() zero-pads.
+     * Frames the activity mask marks inactive are left out.
+     */
+    static std::vector<size_t> frameStarts(size_t length, int frameSize, int hopSize, const ActivityMask* mask = nullptr);
+
+    /**
+     * @brief Symmetric Hann window, as Essentia's Windowing(type=hann, normalized=false).
+     */
+    static std::vector<float> hannWindow(int size);
+
+    /**
+     * @brief Input row of the calling thread's block buffer (frameSize samples).
+     */
+    float* frame(int index) const;
+
+    /**
+     * @brief Copies frameSize samples of audio from start into row index, zero-padding past
+     * the end and multiplying by window when one is given. Like FrameCutter, frames of
+     * digital silence get -100 dB of noise first.
+     */
+    void loadFrame(int index, std::span<const float> audio, size_t start, const float* window) const;
+
+    /**
+     * @brief Transforms rows [0, count) of the calling thread's block.
+     */
+    void execute(int count) const;
+
+    /**
+     * @brief Complex spectrum of row index, getBins() interleaved (re, im) pairs.
+     */
+    const float* spectrum(int index) const;
+
+    // |X[k]|^2 and |X[k]| of row index, getBins() values each
+    void powerSpectrum(int index, float* out) const;
+    void magnitudeSpectrum(int index, float* out) const;
+
+    struct Plans;
+
+private:
+    int frameSize;
+    const Plans* plans;
+};
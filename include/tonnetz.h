@@ -2,12 +2,19 @@
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <bits/stdc++.h>
+#include "activity_mask.h"
 
+/**
+ * @brief Tonal centroid (tonnetz) features: per-frame 12-bin chroma from ChromaEngine,
+ * projected onto the 6-D tonnetz basis, summarised as 6 means followed by 6 stddevs.
+ * No key or chord estimation is run.
+ */
 std::vector<float> extractTonnetzFeatures(
     const std::string& filename,
     int sampleRate,
     essentia::standard::AlgorithmFactory& factory,
     std::vector<float>& featureVector,
-    std::vector<essentia::Real> inputAudio,
-    bool appendToFeatureVector
+    std::span<const essentia::Real> inputAudio,
+    bool appendToFeatureVector,
+    const ActivityMask* activity = nullptr
 );
\ No newline at end of file
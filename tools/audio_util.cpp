@@ -2,6 +2,7 @@
 #include <memory>
 #include <sys/stat.h>
 #include "audio_util.hpp"
+#include "../core/audio/wav_reader.hpp"
 #include <essentia/essentia.h>
 #include <essentia/algorithmfactory.h>
 #include <filesystem>
@@ -10,7 +11,13 @@ using namespace essentia;
 using namespace standard;
 namespace fs = std::filesystem;
 
-std::vector<essentia::Real> AudioUtil::readAudioFile(const std::string& audioFilePath, float& duration, int& sampleRate) {
+std::vector<essentia::Real> AudioUtil::readAudioFile(const std::string& audioFilePath, float& duration, int& sampleRate, int targetSampleRate) {
+    std::vector<Real> audioBuffer;
+    readAudioInto(audioFilePath, audioBuffer, duration, sampleRate, targetSampleRate);
+    return audioBuffer;
+}
+
+void AudioUtil::readAudioInto(const std::string& audioFilePath, std::vector<essentia::Real>& audioBuffer, float& duration, int& sampleRate, int targetSampleRate) {
     if (!fs::exists(audioFilePath)) {
         throw std::runtime_error("Audio file does not exist: " + audioFilePath);
     }
@@ -20,16 +27,25 @@ std::vector<essentia::Real> AudioUtil::readAudioFile(const std::string& audioFil
         throw std::runtime_error("Audio file is empty: " + audioFilePath);
     }
 
+    // Uncompressed WAV (all of our preprocessed data) is decoded natively at its own rate
+    if (WavReader::read(audioFilePath, audioBuffer, sampleRate)) {
+        duration = static_cast<float>(audioBuffer.size()) / static_cast<float>(sampleRate);
+        return;
+    }
+
     std::unique_ptr<Algorithm> audioLoader;
     try {
         // Get algorithm factory
         AlgorithmFactory& factory = AlgorithmFactory::instance();
 
-        // Create audio loader (automatically converts to mono)
-        audioLoader.reset(factory.create("MonoLoader", "filename", audioFilePath));
+        // Create audio loader (automatically converts to mono). With a target rate the loader
+        // resamples chunk by chunk while decoding, so the full-rate signal is never materialised.
+        if (targetSampleRate > 0) {
+            audioLoader.reset(factory.create("MonoLoader", "filename", audioFilePath, "sampleRate", targetSampleRate));
+        } else {
+            audioLoader.reset(factory.create("MonoLoader", "filename", audioFilePath));
+        }
 
-        // Buffer for audio data
-        std::vector<Real> audioBuffer;
         audioLoader->output("audio").set(audioBuffer);
         audioLoader->compute();
 
@@ -40,12 +56,10 @@ std::vector<essentia::Real> AudioUtil::readAudioFile(const std::string& audioFil
         
         // Clean up
         audioLoader.reset();
-        return audioBuffer;
     }
     catch (const std::exception& e) {
         sampleRate = 0;
         duration = -1.0f;
         throw std::runtime_error("Error reading audio file: " + std::string(e.what()));
-        return std::vector<Real>(); 
     }
 }
\ No newline at end of file
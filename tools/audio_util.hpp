@@ -5,5 +5,10 @@
 
 class AudioUtil {
 public:
-    static std::vector<essentia::Real> readAudioFile(const std::string& audioFilePath, float& duration, int& sampleRate);
+    // Decodes a file to mono. targetSampleRate > 0 makes MonoLoader resample while decoding;
+    // uncompressed WAV is always returned at its native rate. sampleRate reports the rate returned.
+    static std::vector<essentia::Real> readAudioFile(const std::string& audioFilePath, float& duration, int& sampleRate, int targetSampleRate = 0);
+
+    // Same, decoding into audioBuffer so a buffer reused across files keeps its capacity
+    static void readAudioInto(const std::string& audioFilePath, std::vector<essentia::Real>& audioBuffer, float& duration, int& sampleRate, int targetSampleRate = 0);
 };
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "feature_extractor.h"
 #include "feature_utils.h"
+#include "feature_cache.h"
+#include "../core/dataset/feature_store.hpp"
+#include "../core/dataset/extraction_journal.hpp"
+#include "../core/audio/pcm_archive.hpp"
+#include "../core/preprocessing/audio_preprocessor.hpp"
+#include "../utils/fftw_planner.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -9,10 +15,10 @@
 #include <random>
 #include <filesystem>
 #include <utility>
+#include <unordered_map>
 #include <chrono>
 #include <iomanip>
 #include <omp.h>
-#include "../tools/tqdm.cpp"
 
 namespace fs = std::filesystem;
 
@@ -27,7 +33,24 @@ void printUsage(const char* programName) {
     std::cout << "Options:" << std::endl;
     std::cout << "  --input-metadata=<path>  Path to cleaned metadata TSV (default: data/processed/metadata_balanced.tsv)" << std::endl;
     std::cout << "  --dataset-path=<path>    Base directory for audio files (default: data/processed)" << std::endl;
-    std::cout << "  --output-dir=<path>      Output directory for TSV files (default: data/features)" << std::endl;
+    std::cout << "  --output-dir=<path>      Output directory for feature files (default: data/features)" << std::endl;
+    std::cout << "  --format=<fmt>           Output format: hfs (binary feature store) or tsv (default: hfs)" << std::endl;
+    std::cout << "  --compress               Deflate the feature store blocks (hfs only, needs zlib)" << std::endl;
+    std::cout << "  --cache-dir=<path>       Reuse features of unchanged clips from this cache (default: disabled)" << std::endl;
+    std::cout << "  --pcm-archive=<path>     Read clips from a PCM archive written by process_dataset (default: disabled)" << std::endl;
+    std::cout << "  --preprocess             Read raw clips and preprocess them in memory before extraction," << std::endl;
+    std::cout << "                           skipping process_dataset (dataset-path then points at the raw clips)" << std::endl;
+    std::cout << "  --save-processed=<dir>   With --preprocess, also write each processed clip as a WAV (debugging)" << std::endl;
+    std::cout << "  --target-duration=<sec>  With --preprocess: clip length after trimming (default: 5.0)" << std::endl;
+    std::cout << "  --no-trim, --no-normalize, --no-noise-reduction, --no-silence-removal" << std::endl;
+    std::cout << "                           With --preprocess: disable a preprocessing stage" << std::endl;
+    std::cout << "  --validate-mfcc[=<n>]    Compare the native MFCC kernel with Essentia on the first n clips" << std::endl;
+    std::cout << "                           (default: 20), report the differences and exit" << std::endl;
+    std::cout << "  --feature-set=<path>     Feature families and parameters (default: MFCC only); copied to" << std::endl;
+    std::cout << "                           <output-dir>/feature_set.txt for stacking to version with the model" << std::endl;
+    std::cout << "  --fftw-wisdom=<path>     FFTW plan wisdom file to reuse and update (default: $HARMONY_FFTW_WISDOM, else none)" << std::endl;
+    std::cout << "  --checkpoint-every=<n>   Commit extracted rows every n samples (default: 200)" << std::endl;
+    std::cout << "  --restart                Discard checkpoints and the saved split, start from scratch" << std::endl;
     std::cout << "  --test-ratio=<ratio>     Test data ratio (0.0-1.0, default: 0.2)" << std::endl;
     std::cout << "  --random-seed=<seed>     Random seed for shuffling (optional)" << std::endl;
     std::cout << "  --help                   Display this help message" << std::endl;
@@ -41,60 +64,52 @@ std::string getParamValue(const std::string& arg, const std::string& paramName)
     return "";
 }
 
-std::vector<std::string> getFeatureNames() {
-    std::vector<std::string> featureNames;
-    
-    // MFCC features (13 coefficients + 13 stddev)
-    // for (int i = 1; i <= 26; i++) {
-    //     featureNames.push_back("mfcc_mean_" + std::to_string(i));
-    // }
-    // for (int i = 1; i <= 26; i++) {
-    //     featureNames.push_back("mfcc_std_" + std::to_string(i));
-    // }
-    
-    // // Chroma features (36 bins + 36 stddev)
-    // for (int i = 1; i <= 36; i++) {
-    //     featureNames.push_back("chroma_mean_" + std::to_string(i));
-    // }
-    // for (int i = 1; i <= 36; i++) {
-    //     featureNames.push_back("chroma_std_" + std::to_string(i));
-    // }
-    
-    // // Spectral Contrast features (6 peaks + 6 valleys + their stddevs)
-    // for (int i = 1; i <= 6; i++) {
-    //     featureNames.push_back("spectral_peak_mean_" + std::to_string(i));
-    // }
-    // for (int i = 1; i <= 6; i++) {
-    //     featureNames.push_back("spectral_valley_mean_" + std::to_string(i));
-    // }
-    // for (int i = 1; i <= 6; i++) {
-    //     featureNames.push_back("spectral_peak_std_" + std::to_string(i));
-    // }
-    // for (int i = 1; i <= 6; i++) {
-    //     featureNames.push_back("spectral_valley_std_" + std::to_string(i));
-    // }
-    
-    // // Tonnetz features (12 HPCP + 1 key strength)
-    // for (int i = 1; i <= 12; i++) {
-    //     featureNames.push_back("tonnetz_hpcp_" + std::to_string(i));
-    // }
-    // featureNames.push_back("tonnetz_key_strength");
-    
-    // Mel Spectrogram features (40 bands + 40 stddev)
-    for (int i = 1; i <= 40; i++) {
-        featureNames.push_back("mel_mean_" + std::to_string(i));
-    }
-    for (int i = 1; i <= 40; i++) {
-        featureNames.push_back("mel_std_" + std::to_string(i));
-    }
-    
-    return featureNames;
-}
-
 void printColored(const std::string& message, const std::string& color) {
     std::cout << color << message << COLOR_RESET << std::endl;
 }
 
+// Largest per-coefficient difference (in the dB-scaled cepstral domain) accepted as a match
+const float MFCC_TOLERANCE = 0.05f;
+
+// Runs the native MFCC kernel and Essentia's MFCC side by side on the first clips
+int validateMfccKernel(const std::vector<std::tuple<std::string, std::string, std::string>>& samples,
+                       const std::string& datasetPath, int clipCount, const FeatureSet& featureSet) {
+    initializeEssentia();
+    int checked = 0, mismatched = 0;
+    float worstError = 0.0f;
+    double meanError = 0.0;
+    for (const auto& [relPath, ageLabel, genderLabel] : samples) {
+        if (checked == clipCount) break;
+        const fs::path fullPath = fs::path(datasetPath) / relPath;
+        if (!fs::exists(fullPath)) continue;
+        try {
+            MfccComparison comparison = validateMFCC(featureSet, fullPath.string());
+            if (comparison.referenceFrames == 0) continue;
+            checked++;
+            worstError = std::max(worstError, comparison.maxAbsError);
+            meanError += comparison.meanAbsError;
+            if (!comparison.matches(MFCC_TOLERANCE)) {
+                mismatched++;
+                std::cout << "  ✗ " << relPath << ": " << comparison.nativeFrames << "/" << comparison.referenceFrames
+                          << " frames, max error " << comparison.maxAbsError << "\n";
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error validating " << fullPath << ": " << e.what() << "\n";
+        }
+    }
+    shutdownEssentia();
+
+    std::cout << "🔬 MFCC kernel vs Essentia on " << checked << " clips: max error " << worstError
+              << ", mean error " << (checked ? meanError / checked : 0.0) << ", " << mismatched << " over tolerance "
+              << MFCC_TOLERANCE << "\n";
+    if (mismatched > 0) {
+        printColored("❌ Native MFCC kernel does not match Essentia", COLOR_RED);
+        return 1;
+    }
+    printColored("✅ Native MFCC kernel matches Essentia", COLOR_GREEN);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     // Record start time
     auto programStart = std::chrono::high_resolution_clock::now();
@@ -105,6 +120,26 @@ int main(int argc, char* argv[]) {
     std::string outputDir = "data/features";
     float testRatio = 0.2f;
     int randomSeed = -1;
+    std::string format = "hfs";
+    bool compress = false;
+    std::string cacheDir;
+    std::string pcmArchivePath;
+    int checkpointEvery = 200;
+    bool restart = false;
+
+    // Fused preprocessing; defaults match process_dataset
+    bool preprocess = false;
+    std::string saveProcessedDir;
+    float targetDuration = 5.0f;
+    bool enableTrim = true;
+    bool enableNormalize = true;
+    bool enableNoiseReduction = true;
+    bool enableSilenceRemoval = true;
+
+    // Native MFCC kernel check against Essentia
+    int validateMfccClips = 0;
+
+    std::string featureSetPath;
 
     // Parse command line arguments
     std::vector<std::string> args(argv + 1, argv + argc);
@@ -112,6 +147,22 @@ int main(int argc, char* argv[]) {
         if (arg == "--help") {
             printUsage(argv[0]);
             return 0;
+        } else if (arg == "--compress") {
+            compress = true;
+        } else if (arg == "--restart") {
+            restart = true;
+        } else if (arg == "--validate-mfcc") {
+            validateMfccClips = 20;
+        } else if (arg == "--preprocess") {
+            preprocess = true;
+        } else if (arg == "--no-trim") {
+            enableTrim = false;
+        } else if (arg == "--no-normalize") {
+            enableNormalize = false;
+        } else if (arg == "--no-noise-reduction") {
+            enableNoiseReduction = false;
+        } else if (arg == "--no-silence-removal") {
+            enableSilenceRemoval = false;
         } else {
             std::string value;
             if (!(value = getParamValue(arg, "input-metadata")).empty()) {
@@ -128,10 +179,58 @@ int main(int argc, char* argv[]) {
                 }
             } else if (!(value = getParamValue(arg, "random-seed")).empty()) {
                 randomSeed = std::stoi(value);
+            } else if (!(value = getParamValue(arg, "checkpoint-every")).empty()) {
+                checkpointEvery = std::stoi(value);
+                if (checkpointEvery < 1) {
+                    std::cerr << "Error: checkpoint-every must be at least 1\n";
+                    return 1;
+                }
+            } else if (!(value = getParamValue(arg, "pcm-archive")).empty()) {
+                pcmArchivePath = value;
+            } else if (!(value = getParamValue(arg, "feature-set")).empty()) {
+                featureSetPath = value;
+            } else if (!(value = getParamValue(arg, "fftw-wisdom")).empty()) {
+                harmony::FftwPlanner::setWisdomFile(value);
+            } else if (!(value = getParamValue(arg, "validate-mfcc")).empty()) {
+                validateMfccClips = std::stoi(value);
+            } else if (!(value = getParamValue(arg, "save-processed")).empty()) {
+                saveProcessedDir = value;
+            } else if (!(value = getParamValue(arg, "target-duration")).empty()) {
+                targetDuration = std::stof(value);
+            } else if (!(value = getParamValue(arg, "cache-dir")).empty()) {
+                cacheDir = value;
+            } else if (!(value = getParamValue(arg, "format")).empty()) {
+                format = value;
+                if (format != "hfs" && format != "tsv") {
+                    std::cerr << "Error: format must be 'hfs' or 'tsv'\n";
+                    return 1;
+                }
             }
         }
     }
 
+    FeatureSet featureSet;
+    if (!featureSetPath.empty()) {
+        try {
+            featureSet = FeatureSet::load(featureSetPath);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (preprocess && !pcmArchivePath.empty()) {
+        std::cerr << "Error: --preprocess reads raw clips and cannot be combined with --pcm-archive\n";
+        return 1;
+    }
+    if (!saveProcessedDir.empty() && !preprocess) {
+        std::cerr << "Error: --save-processed requires --preprocess\n";
+        return 1;
+    }
+    // Only --preprocess has the activity mask; recording which frames were used lets
+    // inference extract the way the model was trained
+    featureSet.activity = preprocess ? "mask" : "none";
+
     // Print startup information
     std::cout << "\n✨ " << COLOR_GREEN << "Starting Feature Extraction Pipeline" << COLOR_RESET << " ✨\n";
     std::cout << std::string(50, '=') << "\n";
@@ -139,6 +238,14 @@ int main(int argc, char* argv[]) {
     std::cout << "▸ Input Metadata:    " << inputMetadata << "\n";
     std::cout << "▸ Dataset Path:      " << datasetPath << "\n";
     std::cout << "▸ Output Directory:  " << outputDir << "\n";
+    std::cout << "▸ Feature Set:       " << featureSet.describe() << " (" << featureSet.featureNames().size() << " features"
+              << (featureSetPath.empty() ? ", default" : ", " + featureSetPath) << ")\n";
+    std::cout << "▸ Output Format:     " << format << (compress && format == "hfs" ? " (compressed)" : "") << "\n";
+    std::cout << "▸ Preprocessing:     " << (preprocess ? "in memory" + (saveProcessedDir.empty() ? std::string() : ", WAVs saved to " + saveProcessedDir)
+                                                        : std::string("done by process_dataset")) << "\n";
+    std::cout << "▸ PCM Archive:       " << (pcmArchivePath.empty() ? "disabled" : pcmArchivePath) << "\n";
+    std::cout << "▸ Feature Cache:     " << (cacheDir.empty() ? "disabled" : cacheDir) << "\n";
+    std::cout << "▸ Checkpoint Every:  " << checkpointEvery << " samples" << (restart ? " (restart)" : "") << "\n";
     std::cout << "▸ Test Split Ratio:  " << testRatio << "\n";
     std::cout << "▸ Random Seed:       " << (randomSeed == -1 ? "System Random" : std::to_string(randomSeed)) << "\n";
     std::cout << std::string(50, '-') << "\n\n";
@@ -174,6 +281,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (validateMfccClips > 0) {
+        return validateMfccKernel(samples, datasetPath, validateMfccClips, featureSet);
+    }
+
     // Shuffle samples
     if (randomSeed != -1) {
         std::mt19937 rng(randomSeed);
@@ -184,51 +295,203 @@ int main(int argc, char* argv[]) {
         std::shuffle(samples.begin(), samples.end(), rng);
     }
 
+    // Checkpoint state lives next to the outputs; --restart throws it away
+    const fs::path checkpointDir = fs::path(outputDir) / ".checkpoint";
+    if (restart) {
+        fs::remove_all(checkpointDir);
+    }
+    fs::create_directories(checkpointDir);
+
+    // Journals hold rows of one feature layout; resuming with another set needs --restart
+    const fs::path checkpointFeatureSet = checkpointDir / FeatureSet::FILE_NAME;
+    try {
+        if (fs::exists(checkpointFeatureSet)) {
+            if (FeatureSet::load(checkpointFeatureSet.string()).signature() != featureSet.signature()) {
+                printColored("❌ Error: Checkpoints were extracted with another feature set; rerun with --restart", COLOR_RED);
+                return 1;
+            }
+        } else {
+            featureSet.save(checkpointFeatureSet.string());
+        }
+    } catch (const std::exception& e) {
+        printColored("❌ Error: " + std::string(e.what()), COLOR_RED);
+        return 1;
+    }
+
+    // Split assignments are persisted so resumed and extended runs keep every clip on the same side
+    const fs::path splitPath = checkpointDir / "split.tsv";
+    std::unordered_map<std::string, std::string> splitOf;
+    {
+        std::ifstream splitFile(splitPath);
+        std::string path, split;
+        while (std::getline(splitFile, line)) {
+            std::istringstream iss(line);
+            if (std::getline(iss, path, '\t') && std::getline(iss, split, '\t')) {
+                splitOf[path] = split;
+            }
+        }
+    }
+
+    std::vector<size_t> unassigned;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (!splitOf.count(std::get<0>(samples[i]))) unassigned.push_back(i);
+    }
+    if (!unassigned.empty()) {
+        // New clips are split with the same ratio, in shuffled order
+        size_t splitIdx = unassigned.size() * (1.0f - testRatio);
+        std::ofstream splitFile(splitPath, std::ios::app);
+        for (size_t k = 0; k < unassigned.size(); ++k) {
+            const std::string& path = std::get<0>(samples[unassigned[k]]);
+            splitOf[path] = (k < splitIdx) ? "train" : "test";
+            splitFile << path << "\t" << splitOf[path] << "\n";
+        }
+        splitFile.flush();
+        if (!splitFile) {
+            printColored("❌ Error: Failed to write " + splitPath.string(), COLOR_RED);
+            return 1;
+        }
+        std::cout << "🆕 Assigned " << unassigned.size() << " new samples to train/test\n";
+    }
+
     // Split into train and test
-    size_t splitIdx = samples.size() * (1.0f - testRatio);
-    auto trainSamples = std::vector<std::tuple<std::string, std::string, std::string>>(
-        samples.begin(), samples.begin() + splitIdx
-    );
-    auto testSamples = std::vector<std::tuple<std::string, std::string, std::string>>(
-        samples.begin() + splitIdx, samples.end()
-    );
+    std::vector<std::tuple<std::string, std::string, std::string>> trainSamples, testSamples;
+    for (const auto& sample : samples) {
+        (splitOf[std::get<0>(sample)] == "test" ? testSamples : trainSamples).push_back(sample);
+    }
 
     // Initialize Essentia
     initializeEssentia();
 
-    // Process batches with progress tracking
-    auto processBatch = [&](const auto& batch, const std::string& filename) -> std::pair<int, int> {
-        std::ofstream out(fs::path(outputDir) / filename);
+    // Clips found in the archive are sliced from the mapping instead of decoded
+    PcmArchive pcmArchive;
+    if (!pcmArchivePath.empty()) {
+        try {
+            pcmArchive.open(pcmArchivePath);
+        } catch (const std::exception& e) {
+            printColored("❌ Error: " + std::string(e.what()), COLOR_RED);
+            return 1;
+        }
+        std::cout << "📦 PCM archive holds " << pcmArchive.size() << " clips\n";
+    }
+
+    // Fused mode: raw clips go through the preprocessing chain and stay in memory
+    std::unique_ptr<AudioPreprocessor> preprocessor;
+    if (preprocess) {
+        preprocessor = std::make_unique<AudioPreprocessor>(targetDuration);
+        preprocessor->enableTrimming(enableTrim);
+        preprocessor->enableNormalization(enableNormalize);
+        preprocessor->enableNoiseReduction(enableNoiseReduction);
+        preprocessor->enableSilenceRemoval(enableSilenceRemoval);
+        std::cout << "🎛️  Preprocessing chain: " << preprocessor->describeChain() << "\n";
+        if (!saveProcessedDir.empty()) {
+            fs::create_directories(saveProcessedDir);
+        }
+    }
+
+    // Journals refuse to resume rows produced under another signature; the activity mask is
+    // part of the feature set signature
+    const std::string preprocessSignature = preprocessor ? preprocessor->settingsSignature() : "none";
+
+    // Preprocessed inputs are keyed by the extractor settings only; raw inputs also by the preprocessing
+    std::unique_ptr<FeatureCache> cache;
+    if (!cacheDir.empty()) {
+        const std::string preprocessKey = preprocessor ? preprocessSignature : "preprocess=none";
+        cache = std::make_unique<FeatureCache>(cacheDir, preprocessKey + "|" + featureSet.signature());
+        std::cout << "🗄️  Feature cache holds " << cache->size() << " entries for the current settings\n\n";
+    }
+
+    // Decodes and cleans a raw clip, then extracts from the buffer in place, skipping the
+    // padding and the frames the preprocessor found no speech in; nothing touches disk
+    // unless --save-processed asked for the intermediate WAV
+    std::vector<essentia::Real> processed;
+    ActivityMask activity;
+    auto extractPreprocessed = [&](const fs::path& rawPath) -> std::vector<float> {
+        float clipDuration = -1.0f;
+        if (!preprocessor->processFile(rawPath.string(), "", clipDuration, essentia::standard::AlgorithmFactory::instance(), processed, false, &activity)) {
+            throw std::runtime_error("Preprocessing failed");
+        }
+        if (!saveProcessedDir.empty()) {
+            fs::path debugPath = fs::path(saveProcessedDir) / rawPath.filename();
+            debugPath.replace_extension(".wav");
+            int sampleRate = 16000;
+            preprocessor->writeAudioFile(processed, sampleRate, debugPath.string(), essentia::standard::AlgorithmFactory::instance());
+        }
+        return getFeatureVector(featureSet, processed, &activity);
+    };
+
+    auto commitCheckpoint = [](harmony::ExtractionJournal& journal, const std::string& name) {
+        try {
+            journal.commit();
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Checkpoint of " + name + " failed (" + e.what() + "); rerun to resume from the last good one");
+        }
+    };
+
+    // Extract every sample of the split that is not yet in its journal, committing periodically
+    auto processBatch = [&](const auto& batch, const std::string& name) -> std::pair<int, int> {
+        harmony::ExtractionJournal journal(checkpointDir.string(), name, preprocessSignature);
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!journal.completed().count(std::get<0>(batch[i]))) pending.push_back(i);
+        }
+
         int successCount = 0;
         int errorCount = 0;
-        const size_t totalFiles = batch.size();
+        const size_t totalFiles = pending.size();
+        std::cout << "♻️  " << name << ": " << journal.committedRows() << " samples already extracted, "
+                  << totalFiles << " remaining\n";
         
         auto batchStart = std::chrono::high_resolution_clock::now();
         
-        Tqdm tqdm(totalFiles, "🚀 Processing " + filename + " (" + std::to_string(totalFiles) + " files)");
+        Tqdm tqdm(totalFiles, "🚀 Processing " + name + " (" + std::to_string(totalFiles) + " files)");
 
-        for (size_t i = 0; i < batch.size(); ++i) {
+        for (size_t i : pending) {
             const auto& [relPath, ageLabel, genderLabel] = batch[i];
             fs::path fullPath = fs::path(datasetPath) / relPath;
+            bool appended = false;
     
             try {
-                if (!fs::exists(fullPath)) {
+                std::span<const float> archived = pcmArchive.view(relPath);
+                if (archived.empty() && !fs::exists(fullPath)) {
                     throw std::runtime_error("File not found");
                 }
     
-                std::vector<float> features = getFeatureVector(fullPath.string());
-                for (const auto& feature : features) {
-                    out << feature << "\t";
+                std::vector<float> features;
+                uint64_t contentHash = 0;
+                if (cache) {
+                    contentHash = archived.empty() ? FeatureCache::hashFile(fullPath.string())
+                                                   : FeatureCache::hashBytes(archived.data(), archived.size_bytes());
                 }
-                out << ageLabel << "\t" << genderLabel << "\n";
+                if (!cache || !cache->lookup(contentHash, features)) {
+                    if (preprocessor) {
+                        features = extractPreprocessed(fullPath);
+                    } else {
+                        features = archived.empty() ? getFeatureVector(featureSet, fullPath.string())
+                                                    : getFeatureVector(featureSet, archived);
+                    }
+                    if (cache && !features.empty()) {
+                        cache->store(contentHash, features);
+                    }
+                }
+                if (features.empty()) {
+                    throw std::runtime_error("No features extracted");
+                }
+                journal.append({relPath, ageLabel, genderLabel, std::move(features)});
+                appended = true;
                 successCount++;
-            } catch (const std::runtime_error& e) {
+            } catch (const std::exception& e) {
                 std::cerr << "\nError processing " << fullPath << ": " << e.what() << "\n";
                 errorCount++;
             }
+
+            // Outside the per-clip try: a failed checkpoint aborts the run at the last good one
+            if (appended && successCount % checkpointEvery == 0) {
+                commitCheckpoint(journal, name);
+            }
     
             tqdm.update();
         }
+        commitCheckpoint(journal, name);
         tqdm.finish();
 
         auto batchEnd = std::chrono::high_resolution_clock::now();
@@ -241,11 +504,67 @@ int main(int argc, char* argv[]) {
         return {successCount, errorCount};
     };
 
+    // Convert a completed journal into the requested output format
+    auto exportSplit = [&](const std::string& name, const std::string& filename) -> bool {
+        harmony::ExtractionJournal journal(checkpointDir.string(), name, preprocessSignature);
+        const bool binary = (format == "hfs");
+        const fs::path outPath = fs::path(outputDir) / filename;
+        std::ofstream out;
+        if (!binary) out.open(outPath);
+        harmony::FeatureStoreWriter store(featureSet.featureNames(), {"age", "gender"});
+
+        try {
+            journal.forEach([&](const harmony::JournalRecord& record) {
+                // Clips dropped from the metadata since they were extracted are left out
+                auto it = splitOf.find(record.path);
+                if (it == splitOf.end() || it->second != name) return;
+                if (binary) {
+                    store.addRow(record.features, {record.ageLabel, record.genderLabel});
+                } else {
+                    for (const auto& feature : record.features) {
+                        out << feature << "\t";
+                    }
+                    out << record.ageLabel << "\t" << record.genderLabel << "\n";
+                }
+            });
+        } catch (const std::exception& e) {
+            printColored("❌ Error: Failed to export " + name + ": " + e.what(), COLOR_RED);
+            return false;
+        }
+        if (binary) {
+            return store.save(outPath.string(), compress);
+        }
+        out.flush();
+        return static_cast<bool>(out);
+    };
+
     // Process both splits
-    auto [trainSuccess, trainErrors] = processBatch(trainSamples, "train.tsv");
-    auto [testSuccess, testErrors] = processBatch(testSamples, "test.tsv");
+    const std::string trainFile = "train." + format;
+    const std::string testFile = "test." + format;
+    int trainSuccess = 0, trainErrors = 0, testSuccess = 0, testErrors = 0;
+    try {
+        std::tie(trainSuccess, trainErrors) = processBatch(trainSamples, "train");
+        std::tie(testSuccess, testErrors) = processBatch(testSamples, "test");
+    } catch (const std::exception& e) {
+        printColored("❌ Error: " + std::string(e.what()), COLOR_RED);
+        return 1;
+    }
+    for (const auto& [name, filename] : {std::pair{"train", trainFile}, std::pair{"test", testFile}}) {
+        if (!exportSplit(name, filename)) {
+            printColored("❌ Error: Failed to write " + filename, COLOR_RED);
+            return 1;
+        }
+    }
+    // Stacking copies this into the model directory, where inference picks it up
+    try {
+        featureSet.save((fs::path(outputDir) / FeatureSet::FILE_NAME).string());
+    } catch (const std::exception& e) {
+        printColored("❌ Error: " + std::string(e.what()), COLOR_RED);
+        return 1;
+    }
 
     // Shutdown Essentia
+    preprocessor.reset();
     shutdownEssentia();
 
     // Calculate total statistics
@@ -261,9 +580,12 @@ int main(int argc, char* argv[]) {
     std::cout << "📊 Total Processed: " << (totalSuccess + totalErrors) << " files\n";
     std::cout << "✅ Successful:      " << COLOR_GREEN << totalSuccess << COLOR_RESET << "\n";
     std::cout << "❌ Failed:          " << (totalErrors > 0 ? COLOR_RED : "") << totalErrors << COLOR_RESET << "\n";
+    if (cache) {
+        std::cout << "🗄️  Cache:           " << cache->hits() << " hits, " << cache->misses() << " misses\n";
+    }
     std::cout << "📂 Output Files:\n";
-    std::cout << "   - " << (fs::path(outputDir) / "train.tsv").string() << "\n";
-    std::cout << "   - " << (fs::path(outputDir) / "test.tsv").string() << "\n";
+    std::cout << "   - " << (fs::path(outputDir) / trainFile).string() << "\n";
+    std::cout << "   - " << (fs::path(outputDir) / testFile).string() << "\n";
     std::cout << std::string(50, '=') << "\n\n";
 
     return (totalErrors == 0) ? 0 : 1;
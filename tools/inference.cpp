@@ -16,9 +16,11 @@
 // Include Harmony headers
 #include "../core/stacking/stacking_classifier.hpp"
 #include "../core/stacking/estimators.hpp"
+#include "../core/stacking/transformers.hpp"
 #include "../core/preprocessing/audio_preprocessor.hpp"
 #include "feature_extractor.h"
 #include "feature_utils.h"
+#include "feature_cache.h"
 #include "../utils/logger.hpp"
 #include "../utils/arg_parser.hpp"
 
@@ -48,6 +50,7 @@ std::unique_ptr<StackingClassifier> loadModelFromFile(const std::string& modelDi
     std::string line;
     int svm_c = 1000;
     double svm_gamma = 0.0001;
+    std::string svm_kernel = "linear";
     int rf_trees = 700;
     int knn_k = 5;
     std::string knn_metric = "euclidean";
@@ -55,7 +58,11 @@ std::unique_ptr<StackingClassifier> loadModelFromFile(const std::string& modelDi
     unsigned seed = 42;
     int nn_hidden1 = 64;
     int nn_hidden2 = 32;
+    std::string nn_inference = "off";  // Not part of the ensemble unless the summary says so
     int n_classes = 2;  // Default for binary classification
+    std::string scaler = "none";  // Models trained before scaling existed have no scaler
+    std::string reducer = "none";
+    int reducer_dims = 16;
 
     std::string prefix = configPrefix.empty() ? "" : configPrefix + "_";
 
@@ -67,12 +74,17 @@ std::unique_ptr<StackingClassifier> loadModelFromFile(const std::string& modelDi
         try {
             if (key == "SVM C") svm_c = std::stoi(value);
             else if (key == "SVM gamma") svm_gamma = std::stod(value);
+            else if (key == "SVM kernel") svm_kernel = value;
             else if (key == "Random Forest trees") rf_trees = std::stoi(value);
             else if (key == "KNN k") knn_k = std::stoi(value);
             else if (key == "KNN metric") knn_metric = value;
             else if (key == "Neural Network hidden1") nn_hidden1 = std::stoi(value);
             else if (key == "Neural Network hidden2") nn_hidden2 = std::stoi(value);
+            else if (key == "Neural Network inference") nn_inference = value;
             else if (key == "Cross-validation folds") n_folds = std::stoi(value);
+            else if (key == "Scaler") scaler = value;
+            else if (key == "Reducer") reducer = value;
+            else if (key == "Reducer dims") reducer_dims = std::stoi(value);
         } catch (const std::exception& e) {
             std::cerr << "Warning: failed to parse '" << key << "': '" << value << "' (" << e.what() << ")\n";
         }
@@ -82,12 +94,19 @@ std::unique_ptr<StackingClassifier> loadModelFromFile(const std::string& modelDi
     std::vector<std::unique_ptr<BaseEstimator>> base_models;
     
     // Uncomment these when needed and properly implemented
-    logger.log("▸ Loading SVM model with C=" + std::to_string(svm_c) + " and gamma=" + std::to_string(svm_gamma), COLOR::RESET);
-    base_models.push_back(std::make_unique<harmony::SVM_ML>(svm_c, svm_gamma));
+    logger.log("▸ Loading " + svm_kernel + " SVM model with C=" + std::to_string(svm_c) + " and gamma=" + std::to_string(svm_gamma), COLOR::RESET);
+    if (svm_kernel == "rbf")
+        base_models.push_back(std::make_unique<harmony::SVM>(svm_c, svm_gamma));
+    else
+        base_models.push_back(std::make_unique<harmony::SVM_ML>(svm_c, svm_gamma));
     logger.log("▸ Loading KNN model with k=" + std::to_string(knn_k) + " and metric=" + knn_metric, COLOR::RESET);
     base_models.push_back(std::make_unique<harmony::KNN>(knn_k, knn_metric));
     // base_models.push_back(std::make_unique<harmony::RandomForest>(rf_trees, 5, n_classes));
-    // base_models.push_back(std::make_unique<harmony::NeuralNet>(nn_hidden1, nn_hidden2, n_classes));
+    if (nn_inference != "off") {
+        // The backend actually used is restored from the saved model
+        logger.log("▸ Loading Neural Network model (" + std::to_string(nn_hidden1) + ", " + std::to_string(nn_hidden2) + " hidden units)", COLOR::RESET);
+        base_models.push_back(std::make_unique<harmony::NeuralNet>(nn_hidden1, nn_hidden2, n_classes));
+    }
     
     // Create meta model
     logger.log("▸ Loading Logistic Regression model with lambda=0.01", COLOR::RESET);
@@ -95,6 +114,18 @@ std::unique_ptr<StackingClassifier> loadModelFromFile(const std::string& modelDi
     
     // Create stacking classifier
     auto classifier = std::make_unique<StackingClassifier>(std::move(base_models), std::move(meta_model));
+    if (scaler != "none") {
+        logger.log("▸ Loading " + scaler + " feature scaler", COLOR::RESET);
+        classifier->addTransformer(std::make_unique<harmony::FeatureScaler>(harmony::FeatureScaler::methodFromString(scaler)));
+    }
+    // Projection sizes come from the saved basis; the constructor arguments only matter for fitting
+    if (reducer == "pca") {
+        logger.log("▸ Loading PCA projection (" + std::to_string(reducer_dims) + " dims)", COLOR::RESET);
+        classifier->addTransformer(std::make_unique<harmony::PCA>(reducer_dims));
+    } else if (reducer == "lda") {
+        logger.log("▸ Loading Fisher LDA projection", COLOR::RESET);
+        classifier->addTransformer(std::make_unique<harmony::FisherLDA>(reducer_dims));
+    }
     
     // Load models
     if (!classifier->loadModels(modelSubdir)) {
@@ -112,6 +143,8 @@ struct Config {
     std::string mode = "combined";
     std::string genderPrefix = "gender_3";
     std::string agePrefix = "age_3";
+    std::string cacheDir;
+    bool denoise = false;
 };
 
 class Inference {
@@ -127,6 +160,7 @@ public:
         logger.log("🚀 Starting inference...", COLOR::GREEN);
         startTimer();
         loadClassifiers();
+        if (!loadFeatureSet()) return 1;
         auto files = getTestFiles();
         if (files.empty()) {
             logger.log("No audio files found in directory: " + config.dataDir, LEVEL::ERROR);
@@ -147,6 +181,7 @@ private:
     std::unique_ptr<StackingClassifier> classifier;
     std::unique_ptr<StackingClassifier> genderClassifier;
     std::unique_ptr<StackingClassifier> ageClassifier;
+    FeatureSet featureSet;
     std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
 
     void parseArguments() {
@@ -157,6 +192,8 @@ private:
         parser.addOption("mode", "Mode: 'combined' for separate gender/age models, 'single' for one model", config.mode);
         parser.addOption("gender-prefix", "Prefix for gender model files", config.genderPrefix);
         parser.addOption("age-prefix", "Prefix for age model files", config.agePrefix);
+        parser.addOption("cache-dir", "Feature cache directory (disabled when empty)", config.cacheDir);
+        parser.addOption("denoise", "Apply spectral noise reduction before feature extraction", false, harmony::ArgParser::FLAG);
         parser.parse();
         config.dataDir = parser.get<std::string>("data-dir");
         config.modelDir = parser.get<std::string>("model-dir");
@@ -164,6 +201,9 @@ private:
         config.mode = parser.get<std::string>("mode");
         config.genderPrefix = parser.get<std::string>("gender-prefix");
         config.agePrefix = parser.get<std::string>("age-prefix");
+        if (parser.has("cache-dir"))
+            config.cacheDir = parser.get<std::string>("cache-dir");
+        config.denoise = parser.get<bool>("denoise");
 
     }
 
@@ -191,6 +231,29 @@ private:
         }
     }
 
+    // The feature set is versioned with the models; in combined mode both models see one
+    // feature vector, so their sets must agree
+    bool loadFeatureSet() {
+        std::vector<std::string> dirs = {config.modelDir};
+        if (config.mode == "combined")
+            dirs = {config.modelDir + "/" + config.genderPrefix, config.modelDir + "/" + config.agePrefix};
+        try {
+            featureSet = FeatureSet::forModel(dirs[0]);
+            for (size_t i = 1; i < dirs.size(); ++i) {
+                if (FeatureSet::forModel(dirs[i]).signature() != featureSet.signature()) {
+                    logger.log("Models in " + dirs[0] + " and " + dirs[i] + " were trained on different feature sets", LEVEL::ERROR);
+                    return false;
+                }
+            }
+        } catch (const std::exception& e) {
+            logger.log(e.what(), LEVEL::ERROR);
+            return false;
+        }
+        logger.log("▸ Feature set: " + featureSet.describe() + " (" + std::to_string(featureSet.featureNames().size()) + " features, "
+                   + (featureSet.activity == "mask" ? "voice-active frames" : "all frames") + ")", COLOR::RESET);
+        return true;
+    }
+
     std::vector<std::string> getTestFiles() const {
         std::vector<std::string> files;
         logger.log("\n📂 Searching for audio files in " + config.dataDir, COLOR::GREEN);
@@ -221,27 +284,50 @@ private:
         using namespace essentia::standard;
         AudioPreprocessor processor(1);
         processor.enableTrimming(false);
-        processor.enableNoiseReduction(false);
+        processor.enableNoiseReduction(config.denoise);
+
+        // Raw clips are hashed, so the preprocessing settings are part of the cache key
+        std::unique_ptr<FeatureCache> cache;
+        if (!config.cacheDir.empty())
+            cache = std::make_unique<FeatureCache>(config.cacheDir, processor.settingsSignature() + "|" + featureSet.signature());
+
         std::vector<std::vector<float>> allFeatures;
         harmony::Logger::ProgressBar progressBar(files.size(), "🔄 Extracting features", COLOR::BLUE);
         for (const auto& file : files) {
             std::string path = config.dataDir + "/" + file;
+            uint64_t contentHash = 0;
+            if (cache) {
+                std::vector<float> cached;
+                contentHash = FeatureCache::hashFile(path);
+                if (cache->lookup(contentHash, cached)) {
+                    allFeatures.push_back(std::move(cached));
+                    progressBar.update();
+                    continue;
+                }
+            }
             float duration;
             std::vector<essentia::Real> buffer;
-            bool ok = processor.processFile(path, "", duration, AlgorithmFactory::instance(), buffer, false);
+            // Masked only when the training features were (feature set "activity")
+            ActivityMask activity;
+            const ActivityMask* mask = featureSet.activity == "mask" ? &activity : nullptr;
+            bool ok = processor.processFile(path, "", duration, AlgorithmFactory::instance(), buffer, false, &activity);
             if (!ok || buffer.empty()) {
                 allFeatures.emplace_back();
                 progressBar.update();
                 continue;
             }
             try {
-                allFeatures.push_back(getFeatureVector("", buffer));
+                allFeatures.push_back(getFeatureVector(featureSet, buffer, mask));
+                if (cache && !allFeatures.back().empty())
+                    cache->store(contentHash, allFeatures.back());
             } catch (...) {
                 allFeatures.emplace_back();
             }
             progressBar.update();
         }
         progressBar.finish();
+        if (cache)
+            logger.log("🗄️  Feature cache: " + std::to_string(cache->hits()) + " hits, " + std::to_string(cache->misses()) + " misses", COLOR::GREEN);
         return allFeatures;
     }
 
@@ -1,6 +1,8 @@
 #include "../core/preprocessing/audio_preprocessor.hpp"
+#include "../core/audio/pcm_archive.hpp"
 #include <iostream>
 #include <filesystem>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -23,6 +25,7 @@ void printUsage(const char* programName) {
     std::cout << "  --noise-threshold=<lvl>: Noise threshold (default: 0.01)" << std::endl;
     std::cout << "  --silence-threshold=<s>: Silence threshold (default: 0.01)" << std::endl;
     std::cout << "  --min-silence-ms=<ms>  : Minimum silence duration in ms (default: 500)" << std::endl;
+    std::cout << "  --pcm-archive=<path>   : Write processed clips into one packed PCM archive instead of WAV files" << std::endl;
     std::cout << "  --no-trim              : Disable trimming" << std::endl;
     std::cout << "  --no-normalize         : Disable volume normalization" << std::endl;
     std::cout << "  --no-noise-reduction   : Disable noise reduction" << std::endl;
@@ -60,6 +63,7 @@ int main(int argc, char* argv[]) {
     int maxFiles = 15000;
     int startLine = 0;
     int endLine = -1;
+    std::string pcmArchivePath;
     
     bool enableTrim = true;
     bool enableNormalize = true;
@@ -105,6 +109,8 @@ int main(int argc, char* argv[]) {
                 startLine = std::stoi(value);
             } else if (!(value = getParamValue(arg, "end-line")).empty()) {
                 endLine = std::stoi(value);
+            } else if (!(value = getParamValue(arg, "pcm-archive")).empty()) {
+                pcmArchivePath = value;
             }
         }
     }
@@ -113,6 +119,7 @@ int main(int argc, char* argv[]) {
     std::cout << "=== Audio Dataset Processor ===" << std::endl;
     std::cout << "TSV file:           " << tsvFile << std::endl;
     std::cout << "Output directory:   " << outputDir << std::endl;
+    std::cout << "PCM archive:        " << (pcmArchivePath.empty() ? "disabled (WAV files)" : pcmArchivePath) << std::endl;
     std::cout << "Max files:          " << maxFiles << std::endl;
     std::cout << "Processing range:   " << startLine << " to " << (endLine == -1 ? "end" : std::to_string(endLine)) << std::endl;
     std::cout << "Target duration:    " << targetDuration << " seconds" << std::endl;
@@ -153,12 +160,28 @@ int main(int argc, char* argv[]) {
     preprocessor.setNoiseThreshold(noiseThreshold);
     preprocessor.setSilenceThreshold(silenceThreshold);
     preprocessor.setMinSilenceMs(minSilenceMs);
+
+    // Batches run with --start-line extend the same archive
+    std::unique_ptr<PcmArchiveWriter> pcmArchive;
+    if (!pcmArchivePath.empty()) {
+        try {
+            pcmArchive = std::make_unique<PcmArchiveWriter>(pcmArchivePath, 16000);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        preprocessor.setPcmArchive(pcmArchive.get());
+    }
     
     // Process files with progress bar
     auto startTime = std::chrono::high_resolution_clock::now();
     
     preprocessor.processBatch(
         tsvFile, outputDir, maxFiles, true, startLine, endLine);
+    if (pcmArchive) {
+        std::cout << "PCM archive holds " << pcmArchive->size() << " clips" << std::endl;
+        pcmArchive->close();
+    }
     
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count();
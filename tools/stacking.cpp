@@ -1,5 +1,9 @@
 #include "../core/stacking/stacking_classifier.hpp"
 #include "../core/stacking/estimators.hpp"
+#include "../core/stacking/transformers.hpp"
+#include "../core/dataset/feature_store.hpp"
+#include "../core/dataset/tsv_loader.hpp"
+#include "../include/feature_set.h"
 #include <eigen3/Eigen/Dense>
 #include <fstream>
 #include <sstream>
@@ -42,87 +46,50 @@ std::string get(const std::string& arg, const std::string& paramName) {
 struct Dataset {
     Eigen::MatrixXd X;
     Eigen::VectorXi y;
+    std::vector<std::string> featureNames;  // Empty for TSV input, which has no header
 };
 
 Dataset loadTSV(const std::string& path, const std::string& target) {
     Dataset dataset;
-    std::ifstream file(path);
-    std::string line;
-    
-    // First pass to count rows and columns
-    int rows = 0;
-    int cols = 0;
-    while (std::getline(file, line)) rows++;
-    file.clear();
-    file.seekg(0);
-    std::getline(file, line);
-    std::istringstream iss(line);
-    std::string cell;
-    while (std::getline(iss, cell, '\t')) cols++;
-    logger.log("🔄 Loaded " + std::to_string(rows) + " rows and " + std::to_string(cols) + " columns from " + path, COLOR::GREEN);
-    // Print number of columns
-    logger.log("🔄 Number of columns: " + std::to_string(cols), COLOR::GREEN);
-    cols -= 2; // Last 2 columns are label
-    
-    // Initialize matrices
-    dataset.X.resize(rows, cols);
-    dataset.y.resize(rows);
-    
-    // Second pass to load data
-    file.seekg(0);
-    int row_idx = 0;
-    harmony::Logger::ProgressBar progressBar(rows, "📂 Loading " + fs::path(path).filename().string());
-    
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        for (int col = 0; col < cols; ++col) {
-            std::string val;
-            std::getline(iss, val, '\t');
-            dataset.X(row_idx, col) = std::stod(val);
-        }
-        std::string ageLabel;
-        std::getline(iss, ageLabel, '\t');
-        std::string genderLabel;
-        std::getline(iss, genderLabel, '\t');
-        if (target == "gender") {
-            dataset.y(row_idx) = (genderLabel == "male") ? 0 : 1;
-        } else if (target == "age") {
-            dataset.y(row_idx) = (ageLabel == "twenties") ? 0 : 1;
-        } else {
-            // Combine predictions to get final class (0-3)
-            // 0: Male + Twenties
-            // 1: Female + Twenties
-            // 2: Male + Fifties
-            // 3: Female + Fifties
-            // if (ageLabel == "twenties") {
-            //     dataset.y(row_idx) = genderLabel == "male" ? 0 : 1;
-            // } else if (ageLabel == "fifties") {
-            //     dataset.y(row_idx) = genderLabel == "male" ? 2 : 3;
-            // }
-            int classLabel = 0;
-            if (ageLabel == "twenties" && genderLabel == "male") {
-                classLabel = 0;
-            } else if (ageLabel == "twenties" && genderLabel == "female") {
-                classLabel = 1;
-            } else if (ageLabel == "fifties" && genderLabel == "male") {
-                classLabel = 2;
-            } else if (ageLabel == "fifties" && genderLabel == "female") {
-                classLabel = 3;
-            }
-            int ageCode = (ageLabel == "twenties") ? 0 : 1;
-            int genderCode = (genderLabel == "male") ? 0 : 1;
-            int label = ageCode * 2 + genderCode;
-            assert(label == classLabel);
-            dataset.y(row_idx) = label;
-        }
-        
-        progressBar.update();
-        row_idx++;
+    harmony::loadFeatureTSV(path, target, dataset.X, dataset.y);
+    logger.log("🔄 Loaded " + std::to_string(dataset.X.rows()) + " rows and " + std::to_string(dataset.X.cols()) + " feature columns from " + path, COLOR::GREEN);
+    return dataset;
+}
+
+Dataset loadFeatureStore(const std::string& path, const std::string& target) {
+    harmony::FeatureStore store;
+    if (!store.open(path)) {
+        throw std::runtime_error("Failed to open feature store " + path);
     }
-    progressBar.finish();
+    logger.log("🔄 Mapped " + std::to_string(store.rows()) + " rows and " + std::to_string(store.cols()) + " features from " + path, COLOR::GREEN);
+
+    Dataset dataset;
+    dataset.X = store.features().cast<double>();
+    dataset.featureNames = store.featureNames();
+
+    // Encode each (age, gender) vocabulary pair once instead of comparing strings per row
+    const auto& ageVocab = store.vocabulary("age");
+    const auto& genderVocab = store.vocabulary("gender");
+    std::vector<int> classOf(ageVocab.size() * genderVocab.size());
+    for (size_t a = 0; a < ageVocab.size(); ++a)
+        for (size_t g = 0; g < genderVocab.size(); ++g)
+            classOf[a * genderVocab.size() + g] = harmony::encodeTarget(ageVocab[a], genderVocab[g], target);
+
+    auto ageCodes = store.labelCodes("age");
+    auto genderCodes = store.labelCodes("gender");
+    dataset.y.resize(store.rows());
+    for (Eigen::Index i = 0; i < store.rows(); ++i)
+        dataset.y(i) = classOf[ageCodes(i) * genderVocab.size() + genderCodes(i)];
     return dataset;
 }
 
+// Binary feature stores are detected by their magic, anything else is parsed as TSV
+Dataset loadDataset(const std::string& path, const std::string& target) {
+    if (harmony::FeatureStore::isFeatureStore(path))
+        return loadFeatureStore(path, target);
+    return loadTSV(path, target);
+}
+
 double calculateAccuracy(const Eigen::VectorXi& y_true, const Eigen::VectorXi& y_pred) {
     int correct = 0;
     for (int i = 0; i < y_true.size(); ++i) {
@@ -132,6 +99,24 @@ double calculateAccuracy(const Eigen::VectorXi& y_true, const Eigen::VectorXi& y
     return static_cast<double>(correct) / y_true.size() * 100.0;
 }
 
+// Fails when a dataset's columns are not the ones the feature set extracts
+bool matchesFeatureSet(const Dataset& dataset, const std::vector<std::string>& expected, const std::string& path) {
+    if (static_cast<size_t>(dataset.X.cols()) != expected.size()) {
+        std::cerr << path << " has " << dataset.X.cols() << " feature columns, but the feature set describes "
+                  << expected.size() << "\n";
+        return false;
+    }
+    if (dataset.featureNames.empty()) return true;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (dataset.featureNames[i] != expected[i]) {
+            std::cerr << path << " column " << i + 1 << " is '" << dataset.featureNames[i]
+                      << "', but the feature set names it '" << expected[i] << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 // Function to ensure a directory exists
 void ensureDirectoryExists(const std::string& path) {
     if (!fs::exists(path)) {
@@ -143,18 +128,27 @@ void ensureDirectoryExists(const std::string& path) {
 int main(int argc, char* argv[]) {
     omp_set_num_threads(std::min(12, omp_get_num_procs()));
     // Configuration
-    std::string train_path = "data/features/train.tsv";
-    std::string test_path = "data/features/test.tsv";
+    std::string train_path = "data/features/train.hfs";
+    std::string test_path = "data/features/test.hfs";
     std::string target = "both";
     int svm_c = 1000;
     double svm_gamma = 0.0001;
+    std::string svm_kernel = "linear";
+    int svm_threads = 0;
+    int svm_cache_size = 200;
     int rf_trees = 700;
     int knn_k = 5;
     std::string knn_metric = "euclidean";
     int n_folds = 5;
     unsigned seed = 42;
+    std::string scaler = "none";
+    std::string reducer = "none";
+    int reducer_dims = 16;
+    std::string feature_set;
     int nn_hidden1 = 64;
     int nn_hidden2 = 32;
+    harmony::NeuralNetConfig nn_config;
+    std::string nn_inference = "off";
 
     harmony::ArgParser parser(argc, argv);
     parser.addOption("train-path", "Path to training data", train_path);
@@ -162,13 +156,28 @@ int main(int argc, char* argv[]) {
     parser.addOption("target", "Prediction target: 'gender', 'age', or 'both'", target);
     parser.addOption("svm-c", "SVM C parameter", svm_c);
     parser.addOption("svm-gamma", "SVM gamma parameter", svm_gamma);
+    parser.addOption("svm-kernel", "SVM kernel: 'linear' (mlpack) or 'rbf' (dlib one-vs-one)", svm_kernel);
+    parser.addOption("svm-threads", "Threads for training the RBF SVM pairwise problems (0 = the cores divided among the base models trained alongside it)", svm_threads);
+    parser.addOption("svm-cache-size", "RBF SVM kernel cache size (rows per binary problem)", svm_cache_size);
     parser.addOption("rf-trees", "Random Forest number of trees", rf_trees);
     parser.addOption("knn-k", "KNN number of neighbors", knn_k);
     parser.addOption("knn-metric", "KNN distance metric (euclidean or manhattan)", knn_metric);
     parser.addOption("nn-hidden1", "Neural Network first hidden layer units", nn_hidden1);
     parser.addOption("nn-hidden2", "Neural Network second hidden layer units", nn_hidden2);
+    parser.addOption("nn-optimizer", "Neural Network optimizer: 'adam' or 'sgd' (with momentum)", nn_config.optimizer);
+    parser.addOption("nn-learning-rate", "Neural Network optimizer step size", nn_config.learningRate);
+    parser.addOption("nn-momentum", "Neural Network momentum (sgd only)", nn_config.momentum);
+    parser.addOption("nn-batch-size", "Neural Network mini-batch size", nn_config.batchSize);
+    parser.addOption("nn-epochs", "Neural Network maximum number of epochs", nn_config.epochs);
+    parser.addOption("nn-validation-split", "Fraction of training data held out for early stopping", nn_config.validationSplit);
+    parser.addOption("nn-patience", "Epochs without validation improvement before stopping", nn_config.patience);
+    parser.addOption("nn-inference", "Neural Network base model: 'off' (default), or its prediction backend 'mlpack', 'fused' or 'int8'", nn_inference);
     parser.addOption("n-folds", "Cross-validation folds", n_folds);
+    parser.addOption("scaler", "Feature scaling before the base models, fitted per CV fold: 'none' (default), 'zscore' or 'robust'", scaler);
+    parser.addOption("reducer", "Dimensionality reduction after scaling: 'none', 'pca' or 'lda'", reducer);
+    parser.addOption("reducer-dims", "Output dimensions of the reducer (lda is capped at classes - 1)", reducer_dims);
     parser.addOption("seed", "Random seed", seed);
+    parser.addOption("feature-set", "Feature set the data was extracted with (default: feature_set.txt next to train-path)", feature_set);
 
     // Parse command line arguments
     parser.parse();
@@ -177,30 +186,104 @@ int main(int argc, char* argv[]) {
     target = parser.get<std::string>("target");
     svm_c = parser.get<int>("svm-c");
     svm_gamma = parser.get<double>("svm-gamma");
+    svm_kernel = parser.get<std::string>("svm-kernel");
+    svm_threads = parser.get<int>("svm-threads");
+    svm_cache_size = parser.get<int>("svm-cache-size");
     rf_trees = parser.get<int>("rf-trees");
     knn_k = parser.get<int>("knn-k");
     knn_metric = parser.get<std::string>("knn-metric");
     nn_hidden1 = parser.get<int>("nn-hidden1");
     nn_hidden2 = parser.get<int>("nn-hidden2");
+    nn_config.optimizer = parser.get<std::string>("nn-optimizer");
+    nn_config.learningRate = parser.get<double>("nn-learning-rate");
+    nn_config.momentum = parser.get<double>("nn-momentum");
+    nn_config.batchSize = parser.get<size_t>("nn-batch-size");
+    nn_config.epochs = parser.get<size_t>("nn-epochs");
+    nn_config.validationSplit = parser.get<double>("nn-validation-split");
+    nn_config.patience = parser.get<size_t>("nn-patience");
+    nn_inference = parser.get<std::string>("nn-inference");
     n_folds = parser.get<int>("n-folds");
+    scaler = parser.get<std::string>("scaler");
+    reducer = parser.get<std::string>("reducer");
+    reducer_dims = parser.get<int>("reducer-dims");
     seed = parser.get<unsigned>("seed");
+    if (parser.has("feature-set"))
+        feature_set = parser.get<std::string>("feature-set");
+    nn_config.seed = seed;
 
     // Validate target
     if (target != "gender" && target != "age" && target != "both") {
         std::cerr << "Invalid target: " << target << ". Must be 'gender', 'age', or 'both'\n";
         return 1;
     }
+    if (scaler != "none" && scaler != "zscore" && scaler != "robust") {
+        std::cerr << "Invalid scaler: " << scaler << ". Must be 'none', 'zscore' or 'robust'\n";
+        return 1;
+    }
+    if (reducer != "none" && reducer != "pca" && reducer != "lda") {
+        std::cerr << "Invalid reducer: " << reducer << ". Must be 'none', 'pca' or 'lda'\n";
+        return 1;
+    }
+    if (reducer_dims < 1) {
+        std::cerr << "Invalid reducer dimensions: " << reducer_dims << ". Must be at least 1\n";
+        return 1;
+    }
+    if (nn_inference != "off" && nn_inference != "mlpack" && nn_inference != "fused" && nn_inference != "int8") {
+        std::cerr << "Invalid neural network inference: " << nn_inference << ". Must be 'off', 'mlpack', 'fused' or 'int8'\n";
+        return 1;
+    }
+    // The SVM takes these as unsigned long / long, where a negative count would wrap
+    if (svm_threads < 0) {
+        std::cerr << "Invalid SVM threads: " << svm_threads << ". Must be 0 (automatic) or more\n";
+        return 1;
+    }
+    if (svm_cache_size < 1) {
+        std::cerr << "Invalid SVM cache size: " << svm_cache_size << ". Must be at least 1\n";
+        return 1;
+    }
+    if (svm_kernel != "linear" && svm_kernel != "rbf") {
+        std::cerr << "Invalid SVM kernel: " << svm_kernel << ". Must be 'linear' or 'rbf'\n";
+        return 1;
+    }
+
+    // The feature layout the models are trained on is versioned with them; inference loads it from the model directory
+    const fs::path featureSetFile = feature_set.empty() ? fs::path(train_path).parent_path() / FeatureSet::FILE_NAME : fs::path(feature_set);
+    const bool haveFeatureSetFile = fs::exists(featureSetFile);
+    if (!haveFeatureSetFile && !feature_set.empty()) {
+        std::cerr << "Feature set " << feature_set << " not found\n";
+        return 1;
+    }
+    FeatureSet featureSet;
+    if (haveFeatureSetFile) {
+        try {
+            featureSet = FeatureSet::load(featureSetFile.string());
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
 
     // Pretty header
     std::cout << "\n🎯 " << COLOR_CYAN << "Starting Stacking Classifier Training" << COLOR_RESET << " 🎯\n";
     std::cout << std::string(60, '=') << "\n";
     std::cout << "⚙️  " << COLOR_YELLOW << "Model Configuration:\n" << COLOR_RESET;
     std::cout << "▸ Base Models:\n";
-    std::cout << "   - SVM with RBF Kernel (C=" << svm_c << ", gamma=" << svm_gamma << ")\n";
+    if (svm_kernel == "rbf") {
+        std::cout << "   - SVM with RBF Kernel (C=" << svm_c << ", gamma=" << svm_gamma
+                  << ", threads=" << svm_threads << ", cache=" << svm_cache_size << ")\n";
+    } else {
+        std::cout << "   - SVM with Linear Kernel (C=" << svm_c << ")\n";
+    }
     std::cout << "   - Random Forest (" << rf_trees << " trees, min_leaf=5)\n";
     std::cout << "   - K-Nearest Neighbors (k=" << knn_k << ", metric=" << knn_metric << ")\n";
     std::cout << "   - Extra Trees (400 trees, min_leaf=5)\n";
-    std::cout << "   - Neural Network (" << nn_hidden1 << ", " << nn_hidden2 << " hidden units)\n";
+    std::cout << "   - Neural Network (" << nn_hidden1 << ", " << nn_hidden2 << " hidden units, "
+              << nn_config.optimizer << " lr=" << nn_config.learningRate << ", batch=" << nn_config.batchSize
+              << ", epochs<=" << nn_config.epochs << ", patience=" << nn_config.patience
+              << ", inference=" << nn_inference << ")\n";
+    std::cout << "▸ Feature Scaling: " << scaler << "\n";
+    if (reducer != "none")
+        std::cout << "▸ Dimensionality Reduction: " << reducer << " (" << reducer_dims << " dims)\n";
     std::cout << "▸ Meta Model: Logistic Regression\n";
     std::cout << "▸ Cross-Validation Folds: " << n_folds << "\n";
     std::cout << "▸ Random Seed: " << seed << "\n";
@@ -210,14 +293,21 @@ int main(int argc, char* argv[]) {
     // Load data
     logger.log("🚀 Loading training data...", COLOR::GREEN);
     auto train_start = std::chrono::high_resolution_clock::now();
-    Dataset train_data = loadTSV(train_path, target);
+    Dataset train_data = loadDataset(train_path, target);
     
     logger.log("\n🚀 Loading test data...", COLOR::GREEN);
-    Dataset test_data = loadTSV(test_path, target);
+    Dataset test_data = loadDataset(test_path, target);
     auto load_end = std::chrono::high_resolution_clock::now();
     
     size_t nClasses = (target == "both" ? 4 : 2);
 
+    const std::vector<std::string> expectedFeatures = featureSet.featureNames();
+    if (!matchesFeatureSet(train_data, expectedFeatures, train_path) || !matchesFeatureSet(test_data, expectedFeatures, test_path)) {
+        std::cerr << "The data was not extracted with feature set '" << featureSet.describe() << "' ("
+                  << (haveFeatureSetFile ? featureSetFile.string() : "default") << "); pass the matching --feature-set\n";
+        return 1;
+    }
+
     std::cout << "\n📊 Dataset Statistics:\n";
     std::cout << "▸ Training Samples: " << COLOR_CYAN << train_data.X.rows() << COLOR_RESET << "\n";
     std::cout << "▸ Test Samples:     " << COLOR_CYAN << test_data.X.rows() << COLOR_RESET << "\n";
@@ -228,11 +318,19 @@ int main(int argc, char* argv[]) {
     // Initialize models
     logger.log("⚡ Initializing models...", COLOR::GREEN);
     std::vector<std::unique_ptr<BaseEstimator>> base_models;
-    base_models.push_back(std::make_unique<harmony::SVM_ML>(svm_c, svm_gamma));
+    if (svm_kernel == "rbf") {
+        base_models.push_back(std::make_unique<harmony::SVM>(svm_c, svm_gamma, svm_threads, svm_cache_size));
+    } else {
+        base_models.push_back(std::make_unique<harmony::SVM_ML>(svm_c, svm_gamma));
+    }
     // base_models.push_back(std::make_unique<harmony::ExtraTrees>(400, 5, nClasses));
     // base_models.push_back(std::make_unique<harmony::RandomForest>(rf_trees, 5, nClasses));
     base_models.push_back(std::make_unique<harmony::KNN>(knn_k, knn_metric));
-    // base_models.push_back(std::make_unique<harmony::NeuralNet>(nn_hidden1, nn_hidden2, nClasses));
+    if (nn_inference != "off") {
+        auto nn = std::make_unique<harmony::NeuralNet>(nn_hidden1, nn_hidden2, nClasses, nn_config);
+        nn->setInferenceMode(harmony::NeuralNet::inferenceModeFromString(nn_inference));
+        base_models.push_back(std::move(nn));
+    }
     auto meta_model = std::make_unique<harmony::LR>(0.001, nClasses);
 
     // Create stacker
@@ -242,6 +340,14 @@ int main(int argc, char* argv[]) {
         n_folds,
         seed
     );
+    if (scaler != "none") {
+        stacker.addTransformer(std::make_unique<harmony::FeatureScaler>(harmony::FeatureScaler::methodFromString(scaler)));
+    }
+    if (reducer == "pca") {
+        stacker.addTransformer(std::make_unique<harmony::PCA>(reducer_dims, 10, 2, seed));
+    } else if (reducer == "lda") {
+        stacker.addTransformer(std::make_unique<harmony::FisherLDA>(reducer_dims));
+    }
 
     // Training
     logger.log("🏋️  Training stacking classifier...", COLOR::GREEN);
@@ -290,14 +396,41 @@ int main(int argc, char* argv[]) {
             summary << "## Parameters\n";
             summary << "SVM C: " << svm_c << "\n";
             summary << "SVM gamma: " << std::fixed << std::setprecision(6) << svm_gamma << "\n";
+            summary << "SVM kernel: " << svm_kernel << "\n";
+            summary << "SVM threads: " << svm_threads << "\n";
+            summary << "SVM cache size: " << svm_cache_size << "\n";
             summary << "Random Forest trees: " << rf_trees << "\n";
             summary << "KNN k: " << knn_k << "\n";
             summary << "KNN metric: " << knn_metric << "\n";
             summary << "Neural Network hidden1: " << nn_hidden1 << "\n";
             summary << "Neural Network hidden2: " << nn_hidden2 << "\n";
+            summary << "Neural Network optimizer: " << nn_config.optimizer << "\n";
+            summary << "Neural Network learning rate: " << nn_config.learningRate << "\n";
+            summary << "Neural Network momentum: " << nn_config.momentum << "\n";
+            summary << "Neural Network batch size: " << nn_config.batchSize << "\n";
+            summary << "Neural Network max epochs: " << nn_config.epochs << "\n";
+            summary << "Neural Network patience: " << nn_config.patience << "\n";
+            summary << "Neural Network validation split: " << nn_config.validationSplit << "\n";
+            summary << "Neural Network inference: " << nn_inference << "\n";
             summary << "Cross-validation folds: " << n_folds << "\n";
+            summary << "Scaler: " << scaler << "\n";
+            summary << "Reducer: " << reducer << "\n";
+            summary << "Reducer dims: " << reducer_dims << "\n";
             summary.close();
         }
+
+        const fs::path modelFeatureSet = fs::path(modelDir) / FeatureSet::FILE_NAME;
+        if (haveFeatureSetFile) {
+            std::error_code ec;
+            fs::copy_file(featureSetFile, modelFeatureSet, fs::copy_options::overwrite_existing, ec);
+            if (ec) {
+                logger.log("❌ Failed to copy feature set " + featureSetFile.string() + " to " + modelFeatureSet.string() + ": " + ec.message(), COLOR::RED);
+                return 1;
+            }
+            logger.log("📐 Feature set copied from " + featureSetFile.string(), COLOR::GREEN);
+        } else {
+            logger.log("⚠️  No feature set found next to " + train_path + "; the models assume the default MFCC set", COLOR::YELLOW);
+        }
     } else {
         logger.log("❌ Failed to save models!", COLOR::RED);
     }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <fftw3.h>
+
+namespace harmony
+{
+
+// FFTW's planner is process-global and not thread-safe (plan execution is). Every
+// plan creation and destruction in the process takes lock(). When a wisdom file is
+// configured ($HARMONY_FFTW_WISDOM or setWisdomFile()), it is read before the first plan
+// and written back after new plans, so FFTW_MEASURE planning is paid once per machine
+// instead of once per run. Nothing is written to disk unless a file was asked for.
+//
+// Header-only so that only the targets that create plans need to link FFTW.
+class FftwPlanner {
+public:
+    // Taken around fftwf_plan_* / fftwf_destroy_plan
+    static std::unique_lock<std::mutex> lock() {
+        return std::unique_lock<std::mutex>(state().mutex);
+    }
+
+    // Overrides $HARMONY_FFTW_WISDOM; empty disables wisdom
+    static void setWisdomFile(const std::string& path) {
+        std::lock_guard<std::mutex> guard(state().mutex);
+        state().wisdomFile = path;
+        state().imported = false;
+    }
+
+    // Call with lock() held, before planning
+    static void importWisdom() {
+        State& s = state();
+        if (s.imported)
+            return;
+        s.imported = true;
+        if (!s.wisdomFile.empty() && std::filesystem::exists(s.wisdomFile))
+            fftwf_import_wisdom_from_filename(s.wisdomFile.c_str());
+    }
+
+    // Call with lock() held, after planning; a failed write only costs the next run's planning time
+    static void exportWisdom() {
+        const std::string& path = state().wisdomFile;
+        if (path.empty())
+            return;
+        std::error_code ec;
+        const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty())
+            std::filesystem::create_directories(parent, ec);
+        fftwf_export_wisdom_to_filename(path.c_str());
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::string wisdomFile = defaultWisdomFile();
+        bool imported = false;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+
+    // Opt-in only: no wisdom file unless the environment names one
+    static std::string defaultWisdomFile() {
+        if (const char* path = std::getenv("HARMONY_FFTW_WISDOM"))
+            return path;
+        return "";
+    }
+};
+
+} // namespace harmony
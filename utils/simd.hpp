@@ -0,0 +1,35 @@
+#pragma once
+
+#if defined(__AVX__) || defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace harmony
+{
+
+// Single-precision dot product of n contiguous values: 8 lanes with AVX, 4 with SSE,
+// scalar for the tail and on other targets. Inputs need no particular alignment.
+inline float dot(const float* a, const float* b, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(__AVX__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+#elif defined(__SSE__)
+    __m128 sum4 = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+#endif
+#if defined(__AVX__) || defined(__SSE__)
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 0x55));
+    sum = _mm_cvtss_f32(sum4);
+#endif
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+} // namespace harmony